@@ -1,10 +1,37 @@
 #include "Algorithm.h"
 
 
+// Capture and analyse one window on the calling core.
 bool Algorithm::calculate(float& angle, float& distance)
 {
+    PROFILE_SCOPE(PROF_CALCULATE);
+    if (!capture_window()) { return false; }
+    return process_window(angle, distance);
+}
+
+// Producer side: fills the free window after a trigger. Owns all I2S reads.
+bool Algorithm::capture_window()
+{
+    PROFILE_SCOPE(PROF_CAPTURE_WINDOW);
+    if (free_running)
+    {
+        // A trigger only re-anchors the transmit schedule.
+        if (triggered) { schedule.anchor(triggerIndex); triggered = false; }
+        return listen();
+    }
+
     if (!get_triggered_state()) { return false; }
-    
+    if (clock.hz != SAMPLE_RATE) { triggered = false; idle_onset(triggerIndex); return false; }
+
+    SignalWindow* window = handoff.try_reserve();
+    if (!window)
+    {
+        // Both windows are still being analysed, drop this trigger.
+        triggered = false;
+        dropped_windows++;
+        return false;
+    }
+
     uint16_t sig_offset = 0; // Should be 0.
     
     uint64_t frames_to_discard = triggerIndex - readIndex;
@@ -16,367 +43,278 @@ bool Algorithm::calculate(float& angle, float& distance)
     }
     else
     {
-        discard_frames((size_t)frames_to_discard - FRAMES_PER_READ); // Discard first part.
-        
-        float noise_l[FRAMES_PER_READ], noise_r[FRAMES_PER_READ];
-        
-        size_t n_samples = read_samples(noise_l, noise_r); // Analyze the last part of the noisefloor.
-        analyzer_l.handle(NOISEFLOOR_N_SAMPLES, noise_l + (n_samples - NOISEFLOOR_N_SAMPLES));
-        analyzer_r.handle(NOISEFLOOR_N_SAMPLES, noise_r + (n_samples - NOISEFLOOR_N_SAMPLES));
+        discard_frames((size_t)frames_to_discard); // Feeds the noise floor up to the trigger.
     }
     
-    size_t frames_read = fetch(sig_left, sig_right, &sig_offset);
+    snapshot_thresholds(window->threshold);
+    window->trigger_index = triggerIndex;
+    window->first_index = readIndex;
+    window->sample_rate = clock.hz;
+    size_t frames_read = fetch(window->frames, &sig_offset);
     
     if (!frames_read) { return false; }
     
     /*
-    memcpy(sig_left, left_test_data, sizeof(left_test_data));
-    memcpy(sig_right, right_test_data, sizeof(right_test_data));
-    size_t frames_read = TEST_DATA_N;
+    window->frames.clear();
+    for (size_t i = 0; i < TEST_DATA_N; i++) {
+        const float frame[CHANNELS] = { left_test_data[i], right_test_data[i] };
+        window->frames.append(frame, 1);
+    }
+    window->frames.finish();
+    frames_read = TEST_DATA_N;
     */
 
-    Serial.println("###################################");
-    
-    Serial.print("Signal offset: "); Serial.print(sig_offset); Serial.println(" samples");
-    float t_diff, sig_delay; // us
-    if (!solve(frames_read, t_diff, sig_delay)) { return false; }
-
-    angle = calc_angle(t_diff);
-    distance = calc_distance(sig_delay, sig_offset);
+    window->n_frames = frames_read;
+    window->sig_offset = sig_offset;
+    window->timed = true;
+    handoff.commit();
     return true;
-
 }
 
-bool Algorithm::solve(size_t n_frames, float& t_diff, float& sig_delay)
+// Consumer side: analyses the oldest captured window and hands it back.
+bool Algorithm::process_window(float& angle, float& distance)
 {
-    unsigned long t_a = micros();
-    size_t signal_start_l, est_peaks_l[N_PEAKS];
-    if (!analyzer_l.analyze(n_frames, signal_start_l, est_peaks_l)) { Serial.println("Failed: analyzer left"); return false; }
-
-    size_t signal_start_r, est_peaks_r[N_PEAKS];
-    if (!analyzer_r.analyze(n_frames, signal_start_r, est_peaks_r)) { Serial.println("Failed: analyzer right"); return false; }
-    t_a = micros() - t_a;
-
-    unsigned long t_n = micros();
-    normalize(n_frames, (size_t)N_PEAKS, est_peaks_l, sig_left);
-    normalize(n_frames, (size_t)N_PEAKS, est_peaks_r, sig_right);
-    t_n = micros() - t_n;
-
-    unsigned long t_i = micros();
-    float peaks_l[N_PEAKS], time_l[N_PEAKS];
-    if (!peak_interpolator_l.interpolate_peaks_parabolic(n_frames, N_PEAKS, est_peaks_l, peaks_l, time_l)) { Serial.println("Failed: interpolator left"); return false; }
-    
-    float peaks_r[N_PEAKS], time_r[N_PEAKS];
-    if (!peak_interpolator_r.interpolate_peaks_parabolic(n_frames, N_PEAKS, est_peaks_r, peaks_r, time_r)) { Serial.println("Failed: interpolator right"); return false; }
-    t_i = micros() - t_i;
-    
-    unsigned long t_c = micros();
-    find_peak_diff(peaks_l, time_l, peaks_r, time_r, t_diff); // Correlate peaks, to find signal diff.
-    t_c = micros() - t_c;
-
-    unsigned long t_d = micros();
-    find_sig_delay(peaks_l, time_l, peaks_r, time_r, N_PEAKS, sig_delay);
-    t_d = micros() - t_d;
+    PROFILE_SCOPE(PROF_PROCESS_WINDOW);
+    SignalWindow* window = handoff.front();
+    if (!window) { return false; }
 
-    float dist = sig_delay * 0.0343f;
-    unsigned long total_t = t_a + t_n + t_i + t_c + t_d;
+    LOG(LOG_WINDOW, (uint32_t)window->sig_offset);
+    solver.set_thresholds(window->threshold);
+    solver.set_sample_rate(window->sample_rate);
 
-    //Serial.print("Signal start left: "); Serial.println(signal_start_l);
-    //Serial.print("Signal start right: "); Serial.println(signal_start_r)
-    
-    //Serial.print("time diff: "); Serial.print(t_diff, 6); Serial.println(" us");
-    Serial.print("angle: "); Serial.print(calc_angle(t_diff), 4); Serial.println(" degrees");
-    //Serial.print("signal delay: "); Serial.print(sig_delay, 6); Serial.println(" us");
-    Serial.print("distance: "); Serial.print(dist, 6); Serial.println(" cm");
-
-    //Serial.print("Analyzation took "); Serial.print(t_a); Serial.println(" us");
-    //Serial.print("Normalization took "); Serial.print(t_n); Serial.println(" us");
-    //Serial.print("Interpolation took "); Serial.print(t_i); Serial.println(" us");
-    //Serial.print("Correlation took "); Serial.print(t_c); Serial.println(" us");
-    //Serial.print("Line fit took "); Serial.print(t_d); Serial.println(" us");
-    //Serial.print("Total time was "); Serial.print(total_t); Serial.println(" us");
-    Serial.flush();
-    
-    return true;
-}
+    Measurement& m = latest.write_slot();
+    float t_diff, sig_delay; // us
+    bool ok = solver.solve(window->frames.samples(), window->n_frames, t_diff, sig_delay, m);
+    if (ok)
+    {
+        angle = Solver::calc_angle(t_diff);
+        distance = window->timed ? calc_distance(sig_delay, *window) : NAN;
 
+        LOG(LOG_RESULT, angle, distance);
 
-static inline float corr_norm(const float* a, const float* b, int n)
-{
-    float num = 0.0f, da = 0.0f, db = 0.0f;
-    for (int i = 0; i < n; ++i) {
-        float x = a[i];
-        float y = b[i];
-        num += x * y;
-        da  += x * x;
-        db  += y * y;
+        m.seq = ++measurement_seq;
+        m.angle = angle;
+        m.distance = distance;
+        m.trigger_index = window->trigger_index;
+        if (!measurements.push(m)) { dropped_measurements++; }
+        latest.publish();
     }
-    float denom = sqrtf(da * db);
-    if (denom < 1e-12f) return -1.0f;
-    return num / denom;
+    if (export_captures && window->sample_rate == SAMPLE_RATE) { capture_export.send(*window); } // Capture files hold one rate.
+    handoff.pop();
+    return ok;
 }
 
-void Algorithm::find_peak_diff(float* peaks_l, float* time_l,
-                               float* peaks_r, float* time_r,
-                               float& t_diff)
+// Loads the stored channel calibration and enables the correction. False when none is stored.
+bool Algorithm::load_calibration()
 {
-    const int N = (int)N_PEAKS;
-
-    // Search lag in peak-index domain
-    int L = 10;
-    if (L > N - 1) L = N - 1;
+    if (!calibration.load()) { return false; }
+    correction.configure(calibration, clock.hz);
+    return true;
+}
 
-    // Fixed overlap length for all lags
-    const int W = N - L;               // same #pairs for each lag
-    const float TIE_EPS = 1e-4f;
+// Measures the channel mismatch from n_bursts bursts sent from straight ahead (angle 0) at
+// distance_cm, then stores it. Blocking, run it before the pipeline tasks are started.
+// Skew: t_diff should be 0. Gain: energy per sample of the peak regions. Base delay: the
+// part of the burst delay not explained by distance_cm.
+bool Algorithm::calibrate(size_t n_bursts, float distance_cm)
+{
+    correction.enabled = false;
+    ChannelCalibration measured;
 
-    int bestLag = 0;
-    float bestCorr = -2.0f;
+    double sum_t_diff = 0.0, sum_delay = 0.0, sum_gain = 0.0;
+    size_t n = 0;
+    unsigned long start = millis();
 
-    for (int lag = -L; lag <= L; ++lag)
+    while (n < n_bursts && millis() - start < CALIBRATION_TIMEOUT_MS)
     {
-        // align: L[i] with R[i+lag]
-        int i0 = (lag < 0) ? -lag : 0;
-        if (i0 + W > N) continue;
+        handle();
+        if (!capture_window()) { continue; }
 
-        float c = corr_norm(peaks_l + i0, peaks_r + i0 + lag, W);
+        SignalWindow* window = handoff.front();
+        solver.set_thresholds(window->threshold);
+        solver.set_sample_rate(window->sample_rate);
 
-        if (c > bestCorr + TIE_EPS ||
-            (fabsf(c - bestCorr) <= TIE_EPS && abs(lag) < abs(bestLag)))
+        Measurement m;
+        float t_diff, sig_delay;
+        if (solver.solve(window->frames.samples(), window->n_frames, t_diff, sig_delay, m) && window->timed
+            && m.confidence >= CALIBRATION_MIN_CONFIDENCE)
         {
-            bestCorr = c;
-            bestLag = lag;
+            const RegionStats& stats_l = solver.stats_l;
+            const RegionStats& stats_r = solver.stats_r;
+            float energy_l = stats_l.energy / (float)(stats_l.end - stats_l.start);
+            float energy_r = stats_r.energy / (float)(stats_r.end - stats_r.start);
+            sum_t_diff += t_diff;
+            sum_delay += sig_delay + (float)window->sig_offset * SampleClock{ window->sample_rate }.frame_us();
+            sum_gain += sqrt((double)energy_l / (double)energy_r);
+            n++;
         }
+        handoff.pop();
     }
 
-    // Now compute delay using median of time differences after shifting by bestLag
-    float dt[N_PEAKS];
-    int n_dt = 0;
-
-    if (bestLag >= 0) {
-        for (int i = 0; i + bestLag < N; ++i) {
-            dt[n_dt++] = time_r[i + bestLag] - time_l[i];  // R - L
-        }
-    } else {
-        int k = -bestLag;
-        for (int i = 0; i + k < N; ++i) {
-            dt[n_dt++] = time_r[i] - time_l[i + k];        // R - L
-        }
-    }
+    if (n < n_bursts) { Serial.println("Calibration failed: not enough bursts"); correction.configure(calibration, clock.hz); return false; }
 
-    // sort (small N)
-    for (int i = 0; i < n_dt - 1; ++i) {
-        int mi = i;
-        for (int j = i + 1; j < n_dt; ++j) if (dt[j] < dt[mi]) mi = j;
-        if (mi != i) { float tmp = dt[i]; dt[i] = dt[mi]; dt[mi] = tmp; }
-    }
+    measured.gain[1] = (float)(sum_gain / n);
+    measured.skew_frames = (float)(sum_t_diff / n) / SAMPLE_T_US; // stored at SAMPLE_RATE whatever the capture rate
+    measured.base_delay_us = (float)(sum_delay / n) - distance_cm / SOUND_SPEED_CM_US;
+    measured.valid = true;
 
-    if (n_dt <= 0) { t_diff = 0.0f; return; }
+    Serial.print("Calibration: gain R "); Serial.print(measured.gain[1], 4);
+    Serial.print(", skew "); Serial.print(measured.skew_frames, 4);
+    Serial.print(" frames, base delay "); Serial.print(measured.base_delay_us, 2); Serial.println(" us");
+    if (fabsf(measured.skew_frames) > CALIBRATION_MAX_SKEW) { Serial.println("Calibration: skew clamped"); }
 
-    // median
-    if (n_dt & 1) t_diff = dt[n_dt / 2];
-    else          t_diff = 0.5f * (dt[n_dt/2 - 1] + dt[n_dt/2]);
+    calibration = measured;
+    correction.configure(calibration, clock.hz);
+    return calibration.save();
 }
 
-
-
-/*
-void Algorithm::find_peak_diff(float* peaks_l, float* time_l, float* peaks_r, float* time_r, float& t_diff)
+void Algorithm::set_free_running(bool enable)
 {
-    const int M = (int)N_PEAKS - 1;
-
-    float dL[N_PEAKS - 1];
-    float dR[N_PEAKS - 1];
-
-    const float DT_EPS = 1e-9f;
-
-    for (int i = 0; i < M; ++i) {
-        float dtL = time_l[i + 1] - time_l[i];
-        float dtR = time_r[i + 1] - time_r[i];
-
-        if (fabsf(dtL) < DT_EPS) dtL = (dtL < 0.0f ? -DT_EPS : DT_EPS);
-        if (fabsf(dtR) < DT_EPS) dtR = (dtR < 0.0f ? -DT_EPS : DT_EPS);
-
-        dL[i] = (peaks_l[i + 1] - peaks_l[i]) / dtL;
-        dR[i] = (peaks_r[i + 1] - peaks_r[i]) / dtR;
-    }
-
-    // Optional, but fine to keep if you already have it.
-    // If normalize_der does abs-max only, the per-lag normalization below still protects you.
-    normalize_der(M, dL);
-    normalize_der(M, dR);
-
-    int bestLag = 0;
-    float bestCorr = -1.0f;
-
-    int L = 10;
-    if (L > M - 1) L = M - 1;
-
-    const int MIN_OVERLAP = 8;
-
-    for (int lag = -L; lag <= L; ++lag) {
-        float num = 0.0f;
-        float denL = 0.0f;
-        float denR = 0.0f;
-        int count = 0;
-
-        for (int i = 0; i < M; ++i) {
-            int j = i + lag;
-            if ((unsigned)j >= (unsigned)M) continue;
-
-            float a = dL[i];
-            float b = dR[j];
-            num  += a * b;
-            denL += a * a;
-            denR += b * b;
-            ++count;
-        }
-
-        if (count < MIN_OVERLAP) continue;
-
-        float denom = sqrtf(denL * denR);
-        if (denom < 1e-12f) continue;
-
-        float corr = num / denom;
-        if (corr > bestCorr) {
-            bestCorr = corr;
-            bestLag = lag;
-        }
-    }
-
-    // Build dt array using the SAME alignment as correlation:
-    // correlation aligns dL[i] with dR[i+lag]
-    // so times align time_l[i] with time_r[i+lag]
-    float dt[N_PEAKS];
-    int n_dt = 0;
-
-    if (bestLag >= 0) {
-        for (int i = 0; i + bestLag < (int)N_PEAKS; ++i) {
-            dt[n_dt++] = time_r[i + bestLag] - time_l[i];   // R - L
-        }
-    } else {
-        int k = -bestLag;
-        for (int i = 0; i + k < (int)N_PEAKS; ++i) {
-            dt[n_dt++] = time_r[i] - time_l[i + k];         // R - L
-        }
-    }
-
-    if (n_dt <= 0) {
-        t_diff = 0.0f;
-        return;
-    }
-
-    // sort dt (small N -> simple sort is fine)
-    for (int i = 0; i < n_dt - 1; ++i) {
-        int min_i = i;
-        for (int j = i + 1; j < n_dt; ++j) {
-            if (dt[j] < dt[min_i]) min_i = j;
-        }
-        if (min_i != i) {
-            float tmp = dt[i];
-            dt[i] = dt[min_i];
-            dt[min_i] = tmp;
-        }
-    }
-
-    // median
-    if (n_dt & 1) {
-        t_diff = dt[n_dt / 2];
-    } else {
-        t_diff = 0.5f * (dt[n_dt / 2 - 1] + dt[n_dt / 2]);
-    }
+    free_running = enable;
+    schedule.period_frames = (uint32_t)clock.frames_ms(TX_PERIOD_MS);
+    onset.reset();
+    listen_n[0] = listen_n[1] = 0;
+    holdoff_until = 0;
 }
-*/
-
 
-void Algorithm::normalize_der(size_t n_der, float* der)
+// Free-running capture: decodes every available block and runs the streaming onset
+// detector over it. Opens a window on the first onset outside the holdoff.
+bool Algorithm::listen()
 {
-    if (n_der < 2) return;
-
-    float mean = 0.0f;
-    for (size_t i = 0; i < n_der; ++i) mean += der[i];
-    mean /= (float)n_der;
-
-    float var = 0.0f;
-    for (size_t i = 0; i < n_der; ++i) {
-        float x = der[i] - mean;
-        var += x * x;
-    }
-    var /= (float)(n_der - 1);
+    float thresholds[CHANNELS], onset_thresholds[CHANNELS];
 
-    float std = sqrtf(var);
-    if (std < 1e-12f) {
-        for (size_t i = 0; i < n_der; ++i) der[i] = 0.0f;
-        return;
+    while (frameCounter.get() - readIndex >= FRAMES_PER_READ + SAFE_FRAME_READ_DIFF)
+    {
+        uint8_t cur = listen_cur;
+        float* block = listen_blocks[cur];
+        listen_index[cur] = readIndex;
+        listen_n[cur] = read_interleaved(block);
+        if (!listen_n[cur]) { return false; }
+        listen_cur ^= 1;
+
+        // The decode above already fed this block to the noise floor.
+        snapshot_thresholds(thresholds);
+        for (int c = 0; c < CHANNELS; c++) { onset_thresholds[c] = SignalAnalyzer::fixed_threshold(thresholds[c]); }
+        for (size_t k = 0; k < listen_n[cur]; k++)
+        {
+            uint64_t index = listen_index[cur] + k;
+            if (onset.step(block + k * CHANNELS, onset_thresholds) && index >= holdoff_until)
+            {
+                if (clock.hz != SAMPLE_RATE) { idle_onset(index); return false; }
+                return open_window(index + 1 - ENERGY_WINDOW, thresholds);
+            }
+        }
     }
-
-    float inv = 1.0f / std;
-    for (size_t i = 0; i < n_der; ++i) der[i] = (der[i] - mean) * inv;
+    return false;
 }
 
-void Algorithm::find_sig_delay(float* peaks_l, float* time_l, float* peaks_r, float* time_r, size_t n_peaks, float& sig_delay)
+void Algorithm::snapshot_thresholds(float* thresholds)
 {
-    float a, b;
-    fit_line(time_l, peaks_l, (int)n_peaks, a, b);
-    float start_l = calc_intercept(a, b);
-    
-    fit_line(time_r, peaks_r, (int)n_peaks, a, b);
-    float start_r = calc_intercept(a, b);
-
-    //sig_delay = (start_l + start_r) / 2.0f; // mean dist
-    sig_delay = fminf(start_l, start_r); // shortest dist
+    for (int c = 0; c < CHANNELS; c++) { thresholds[c] = SignalAnalyzer::noise_threshold(noise_floor[c]); }
 }
 
-bool Algorithm::fit_line(float* t, float* peaks, int n_peaks, float& a, float& b)
+// Fills a window from PRE_ONSET_FRAMES before the onset: first from the listen blocks
+// still in memory, then with fresh reads.
+bool Algorithm::open_window(uint64_t onset_index, const float* thresholds)
 {
-    if (n_peaks < 2) { return false; }
-
-    float T  = 0.0f; // sum t
-    float Y  = 0.0f; // sum y
-    float TT = 0.0f; // sum t^2
-    float TY = 0.0f; // sum t*y
-
-    for (int i = 0; i < n_peaks; ++i) {
-        float ti = t[i];
-        float yi = peaks[i];
-        T  += ti;
-        Y  += yi;
-        TT += ti * ti;
-        TY += ti * yi;
+    const uint64_t holdoff = clock.frames_ms(ONSET_HOLDOFF_MS);
+
+    SignalWindow* window = handoff.try_reserve();
+    if (!window)
+    {
+        dropped_windows++;
+        holdoff_until = onset_index + holdoff;
+        return false;
     }
 
-    float Nf = (float)n_peaks;
-    float D = Nf * TT - T * T;
+    uint64_t emission = schedule.valid ? schedule.emission_before(onset_index) : onset_index;
+    uint64_t start = (onset_index > PRE_ONSET_FRAMES) ? onset_index - PRE_ONSET_FRAMES : 0;
+    if (start < emission) { start = emission; }
 
-    if (fabsf(D) < 1e-9f) { return false; } // vertical, no good.
+    // Oldest block first, the previous block only counts if it is contiguous with the current.
+    uint8_t prev = listen_cur, cur = listen_cur ^ 1;
+    if (listen_index[prev] + listen_n[prev] != listen_index[cur]) { listen_n[prev] = 0; }
+    if (listen_n[prev] == 0 && start < listen_index[cur]) { start = listen_index[cur]; }
 
-    a = (Nf * TY - T * Y) / D;
-    b = (Y - a * T) / Nf;
+    WindowFrames& frames = window->frames;
+    frames.clear();
+    const uint8_t order[2] = { prev, cur };
+    for (int b = 0; b < 2; b++)
+    {
+        uint8_t i = order[b];
+        size_t k = (listen_index[i] < start) ? (size_t)(start - listen_index[i]) : 0;
+        if (k < listen_n[i]) { frames.append(listen_blocks[i] + k * CHANNELS, listen_n[i] - k); }
+    }
+
+    noise_tracking = false;
+    while (frames.size() < FRAMES_PER_SIGNAL)
+    {
+        size_t room;
+        WindowFrames::Sample* frame_buf = frames.stage(room);
+        size_t frames_read = read_interleaved(frame_buf, room);
+        if (frames_read == 0) { break; }
+        frames.commit(frames_read);
+    }
+    frames.finish();
+    noise_tracking = true;
+    size_t n = frames.size();
+
+    for (int c = 0; c < CHANNELS; c++) { window->threshold[c] = thresholds[c]; }
+
+    window->n_frames = n;
+    window->trigger_index = emission;
+    window->first_index = start;
+    window->sample_rate = clock.hz;
+    // An onset too long after the emission does not fit sig_offset (341 ms at 192 kHz, the
+    // period is longer) and is no echo of it: keep the window, but without a distance.
+    uint64_t offset = start - emission;
+    window->timed = schedule.valid && offset <= UINT16_MAX;
+    window->sig_offset = window->timed ? (uint16_t)offset : 0;
+    handoff.commit();
+
+    onset.reset();
+    listen_n[0] = listen_n[1] = 0;
+    holdoff_until = start + n + holdoff;
     return true;
 }
 
-float Algorithm::calc_intercept(float a, float b)
+float Algorithm::calc_distance(float sig_delay, const SignalWindow& window)
 {
-    return -b / a;
+    float frame_us = SampleClock{ window.sample_rate }.frame_us();
+    return Solver::calc_distance(sig_delay, window.sig_offset, frame_us, calibration.base_delay_us + correction.group_delay_us(frame_us));
 }
 
-float Algorithm::calc_angle(float t_diff)
+// Applied by handle() on the capture core, see request_sample_rate().
+bool Algorithm::switch_sample_rate(uint32_t hz)
 {
-    float theta = t_diff * ANGLE_K;
-    theta = fminf(1.0f, fmaxf(-1.0f, theta));
-    return asinf(theta) * RAD_TO_DEG;
+    if (!set_sample_rate(hz)) { return false; }
+
+    // Frame indices from before the switch are on another time base.
+    schedule.valid = false;
+    schedule.period_frames = (uint32_t)clock.frames_ms(TX_PERIOD_MS);
+    triggered = false;
+    onset.reset();
+    listen_n[0] = listen_n[1] = 0;
+    holdoff_until = 0;
+    return true;
 }
 
-float Algorithm::calc_distance(float sig_delay, uint16_t sig_offset)
+// A trigger or onset below SAMPLE_RATE, where nothing is measured (see SampleRate.h).
+void Algorithm::idle_onset(uint64_t index)
 {
-    float sig_delay_offset = (float)sig_offset * 1000.0 / 192.0; // us
-    return (sig_delay + sig_delay_offset) * 0.0343f; // cm
+    idle_onsets++;
+    onset.reset();
+    holdoff_until = index + clock.frames_ms(ONSET_HOLDOFF_MS);
+    if (wake_from_idle) { switch_sample_rate(SAMPLE_RATE); }
 }
 
 void Algorithm::handle()
 {
+    PROFILE_SCOPE(PROF_HANDLE);
     unsigned long now = millis();
-    float noise_l[FRAMES_PER_READ], noise_r[FRAMES_PER_READ];
+
+    uint32_t rate = requested_rate.exchange(0);
+    if (rate && rate != clock.hz) { switch_sample_rate(rate); }
 
     if (now - last_resync_millis >= RESYNC_READINDEX_MS) { sync_indicies(); }
     
@@ -389,62 +327,12 @@ void Algorithm::handle()
     // Buffer has been filled, we need to empty it.
     if (write_index - readIndex >= DMA_BUF_LEN * DMA_BUF_COUNT)
     {
-        discard_frames(DMA_BUF_LEN * DMA_BUF_COUNT - FRAMES_PER_READ); // Discard most of the buffer.
-        
-        size_t n_samples = read_samples(noise_l, noise_r); // Analyze the last part of the noisefloor.
-        if (n_samples >= NOISEFLOOR_N_SAMPLES)
-        {
-            analyzer_l.handle(NOISEFLOOR_N_SAMPLES, noise_l + (n_samples - NOISEFLOOR_N_SAMPLES));
-            analyzer_r.handle(NOISEFLOOR_N_SAMPLES, noise_r + (n_samples - NOISEFLOOR_N_SAMPLES));
-        }
+        discard_frames(DMA_BUF_LEN * DMA_BUF_COUNT); // Empty the buffer, the noise floor sees all of it.
         sync_indicies();
         return;
     }
 
     // Keep up with the write pointer.
-    if (read_lag >= FLUSH_DMA_BUFFER_THRESHOLD + NOISEFLOOR_N_SAMPLES)
-    {
-        discard_frames((size_t)read_lag - FRAMES_PER_READ); // Discard first part.
+    if (read_lag >= FLUSH_DMA_BUFFER_THRESHOLD) { discard_frames((size_t)read_lag); }
 
-        size_t n_samples = read_samples(noise_l, noise_r); // Analyze the last part of the noisefloor.
-        analyzer_l.handle(NOISEFLOOR_N_SAMPLES, noise_l + (n_samples - NOISEFLOOR_N_SAMPLES));
-        analyzer_r.handle(NOISEFLOOR_N_SAMPLES, noise_r + (n_samples - NOISEFLOOR_N_SAMPLES));
-    }
-
-}
-
-void Algorithm::normalize(size_t n_frames, size_t n_peaks, size_t* est_peaks, float* channel)
-{
-    
-    int start_index = est_peaks[0] - INTERPOLATION_NEIGHBOURS - 2;
-    if (start_index < 0) { start_index = 0; }
-
-    int end_index = est_peaks[n_peaks-1] + INTERPOLATION_NEIGHBOURS + 2;
-    if (end_index > (int)n_frames) { end_index = (int)n_frames; }
-    
-
-    // Compute mean (DC offset)
-    float sum = 0.0f;
-    for (size_t i = (size_t)start_index; i < (size_t)end_index; i++) {
-        sum += channel[i];
-    }
-    float mean = sum / (float)n_frames;
-    //Serial.print("DC offset: "); Serial.print(mean, 4); Serial.println(" V");
-
-    // Remove DC + find abs max
-    float abs_max = 0.0f;
-    for (size_t i = (size_t)start_index; i < (size_t)end_index; i++) {
-        channel[i] -= mean;
-        float a = fabsf(channel[i]);
-        if (a > abs_max) { abs_max = a; }
-    }
-    //Serial.print("Abs max: "); Serial.print(abs_max, 4); Serial.println(" V");
-
-    // Normalize
-    if (abs_max > 1e-12f) {
-        float inv = 1.0f / abs_max;
-        for (size_t i = 0; i < n_frames; i++) {
-            channel[i] *= inv;
-        }
-    }
 }
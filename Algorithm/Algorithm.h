@@ -1,48 +1,87 @@
+#include <atomic>
 #include "Sampler.h"
 #include "Bandpass.h"
-#include "SignalAnalyzer.h"
-#include "PeakInterpolator.h"
+#include "FixedSolver.h"
+#include "SignalWindow.h"
+#include "OnsetDetector.h"
+#include "Measurement.h"
+#include "LatestMailbox.h"
+#include "CaptureExport.h"
 #include "test_data.h"
 
-#define NOISEFLOOR_N_SAMPLES 30
-#define SOUND_SPEED 343.0f
-#define SENSOR_DISTANCE_M 0.1f
-#define ANGLE_K (SOUND_SPEED / SENSOR_DISTANCE_M) * 1e-6f
-#define RAD_TO_DEG 57.29577951308232f
+#define TX_PERIOD_MS 1000 // Burst period of the transmitter, see TxCodeFinal_V1.ino
+#define PRE_ONSET_FRAMES 64 // Frames kept before a free-running onset
+#define ONSET_HOLDOFF_MS 20 // No new free-running window this long after one (burst tail, echoes)
+#define CALIBRATION_MIN_CONFIDENCE 0.9f // Bursts below this peak correlation are not used for calibration
+#define CALIBRATION_TIMEOUT_MS 60000
 
 
 class Algorithm : public Sampler {
     public:
     //using Sampler::Sampler;
     Algorithm(const int bclkPin, const int lrclkPin, const int dataInPin, const int sync_pulse_pin)
-    : Sampler(bclkPin, lrclkPin, dataInPin, sync_pulse_pin),
-    analyzer_l(sig_left),
-    analyzer_r(sig_right),
-    peak_interpolator_l(sig_left),
-    peak_interpolator_r(sig_right) {}
+    : Sampler(bclkPin, lrclkPin, dataInPin, sync_pulse_pin) {}
 
     bool calculate(float& angle, float& distance);
+    bool capture_window();
+    bool process_window(float& angle, float& distance);
+    bool window_ready() { return handoff.front() != nullptr; }
+
+    // Free-running mode: windows are opened by the onset detector instead of the trigger pin.
+    // Distance is timed against the transmit schedule, anchored by anchor_schedule() or a trigger.
+    void set_free_running(bool enable);
+    bool is_free_running() { return free_running; }
+    void anchor_schedule(uint64_t emission_index) { schedule.anchor(emission_index); }
     void handle();
+
+    // Capture rate, SAMPLE_RATE or IDLE_SAMPLE_RATE_HZ for low power listening. Safe from any
+    // core: the capture core switches on its next handle(). Below SAMPLE_RATE no window is
+    // captured: a trigger or onset is counted in idle_onsets and, with wake_from_idle, switches
+    // back to SAMPLE_RATE. A free-running transmit schedule needs a new anchor after a switch.
+    void request_sample_rate(uint32_t hz) { requested_rate = hz; }
+    bool wake_from_idle = true;
+    uint32_t idle_onsets = 0;
+
+    // Every analysed window, failed or not, is also sent to host/capture_receiver.
+    void set_capture_export(bool enable) { export_captures = enable; }
+    CaptureExport capture_export;
+
+    // Channel gain and delay calibration, see ChannelCalibration.h.
+    bool load_calibration();
+    bool calibrate(size_t n_bursts, float distance_cm);
+
+    uint32_t dropped_windows = 0;
+
+    // Published by process_window(). The mailbox always holds the newest measurement,
+    // the queue keeps every measurement until its consumer pops it. One reader each.
+    LatestMailbox<Measurement> latest;
+    SpscQueue<Measurement, MEASUREMENT_QUEUE_LEN> measurements;
+    uint32_t dropped_measurements = 0;
+
     private:
-    bool solve(size_t n_frames, float& t_diff, float& sig_delay);
-    bool estimate_peaks(size_t n_frames, size_t* est_peaks, size_t peak_idx);
-    bool find_peaks(size_t n_frames, size_t* est_peaks, float* peaks);
-    void find_peak_diff(float* peaks_l, float* time_l, float* peaks_r, float* time_r, float& t_diff);
-    void find_sig_delay(float* peaks_l, float* time_l, float* peaks_r, float* time_r, size_t n_peaks, float& sig_delay);
-    float calc_angle(float t_diff);
-    float calc_distance(float sig_delay, uint16_t sig_offset);
-    void normalize(size_t n_frames, size_t n_peaks, size_t* est_peaks, float* channel);
-    void normalize_der(size_t n_der, float* der);
-    bool fit_line(float* t, float* peaks, int n_peaks, float& a, float& b);
-    float calc_intercept(float a, float b);
-
-    float sig_left[FRAMES_PER_SIGNAL];
-    float sig_right[FRAMES_PER_SIGNAL];
+    bool listen();
+    bool open_window(uint64_t onset_index, const float* thresholds);
+    void snapshot_thresholds(float* thresholds);
+    float calc_distance(float sig_delay, const SignalWindow& window);
+    bool switch_sample_rate(uint32_t hz);
+    void idle_onset(uint64_t index);
+
+    WindowHandoff& handoff = hot_arena.handoff;
+
+    uint32_t measurement_seq = 0;
+
+    bool free_running = false;
+    bool export_captures = false;
+    OnsetDetector onset;
+    TransmitSchedule schedule;
+    float (*listen_blocks)[CHANNELS * FRAMES_PER_READ] = hot_arena.listen;
+    uint64_t listen_index[2] = {0, 0};
+    size_t listen_n[2] = {0, 0};
+    uint8_t listen_cur = 0;
+    uint64_t holdoff_until = 0;
+    std::atomic<uint32_t> requested_rate{0};
 
     Bandpass bandpass;
-    SignalAnalyzer analyzer_l;
-    SignalAnalyzer analyzer_r;
-    PeakInterpolator peak_interpolator_l;
-    PeakInterpolator peak_interpolator_r;
+    WindowSolver solver; // Used by the analysis core only. FixedSolver with FIXED_POINT_PIPELINE.
 
 };
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include "SignalAnalyzer.h"
+
+#define PEAK_LAG 10 // peak index lag searched by Solver::find_peak_diff, either way
+
+// Detector and correlation settings that can change without a rebuild. The macros are the
+// defaults and the capacities: n_peaks <= N_PEAKS. host/autotune sweeps these over a
+// labelled corpus and writes tuned_params.h, which replaces the defaults when present.
+// ENERGY_WINDOW and INTERPOLATION_NEIGHBOURS size buffers and tables and stay compile time.
+struct AnalysisParams {
+    uint8_t n_peaks = N_PEAKS;
+    uint8_t min_i_diff = MIN_I_DIFF; // frames between peaks
+    uint8_t max_i_diff = MAX_I_DIFF;
+    uint8_t peak_lag = PEAK_LAG;
+
+    bool valid() const
+    {
+        return n_peaks >= 2 && n_peaks <= N_PEAKS && min_i_diff >= 1 && min_i_diff <= max_i_diff
+            && peak_lag < n_peaks;
+    }
+};
+
+#if __has_include("tuned_params.h")
+#include "tuned_params.h"
+#endif
+
+#ifndef TUNED_ANALYSIS_PARAMS
+#define TUNED_ANALYSIS_PARAMS AnalysisParams()
+#endif
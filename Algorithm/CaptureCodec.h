@@ -0,0 +1,279 @@
+#pragma once
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Wire format of the capture export (CaptureExport.h), shared with host/capture_receiver.
+//
+// One packet per window, little endian:
+//   CapturePacketHeader (CAPTURE_PACKET_HEADER bytes, packed as listed)
+//   per channel: the samples as 24 bit converter codes, first differences, zigzag mapped and
+//                Rice coded with the channel's k, MSB first, padded to a byte
+//   crc16 (CCITT) of everything before it
+// The packet is COBS encoded and sent as 0, encoded bytes, 0, so a receiver finds the next
+// packet after any garbage and never sees a 0 inside one.
+//
+// Samples are quantized to the 24 bits the PCM1809 delivers. A channel whose Rice code would
+// be longer than 24 bits per sample is sent as plain 24 bit codes (k = CAPTURE_K_RAW).
+
+#define CAPTURE_PACKET_MAGIC 0xC5
+#define CAPTURE_PACKET_VERSION 1
+#define CAPTURE_PACKET_HEADER 36
+#define CAPTURE_K_RAW 0xFF
+#define CAPTURE_RICE_ESCAPE 24 // quotients this long are sent as an escape and 26 raw bits
+#define CAPTURE_MAX_CHANNELS 2
+
+static const float CAPTURE_VOLTS_PER_CODE = 2.0f * 1.41421356237f / 8388608.0f; // 2^23 codes per peak full scale
+
+struct CapturePacketHeader {
+    uint16_t seq;            // counts packets, gaps are lost windows
+    uint64_t trigger_index;  // emission the window is timed against
+    uint64_t first_index;    // read index of the first frame
+    uint16_t n_frames;
+    uint16_t sig_offset;
+    uint8_t timed;
+    uint8_t channels;
+    uint8_t k[CAPTURE_MAX_CHANNELS];
+    float threshold[CAPTURE_MAX_CHANNELS];
+};
+
+// Worst case packet and COBS frame sizes for n_frames stereo frames.
+static inline size_t capture_packet_max(size_t n_frames) { return CAPTURE_PACKET_HEADER + CAPTURE_MAX_CHANNELS * 3 * n_frames + 2; }
+static inline size_t capture_frame_max(size_t packet_len) { return packet_len + packet_len / 254 + 3; }
+
+static inline int32_t capture_quantize(float v)
+{
+    float c = roundf(v / CAPTURE_VOLTS_PER_CODE);
+    if (c > 8388607.0f) { c = 8388607.0f; }
+    if (c < -8388608.0f) { c = -8388608.0f; }
+    return (int32_t)c;
+}
+
+static inline uint32_t capture_zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t capture_unzigzag(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+static inline uint16_t capture_crc16(const uint8_t* p, size_t n)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < n; i++)
+    {
+        crc ^= (uint16_t)p[i] << 8;
+        for (int b = 0; b < 8; b++) { crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1); }
+    }
+    return crc;
+}
+
+struct CaptureBitWriter {
+    uint8_t* p;
+    uint64_t acc = 0;
+    int n = 0;
+
+    explicit CaptureBitWriter(uint8_t* out) : p(out) {}
+
+    inline void put(uint32_t bits, int count) // count <= 32
+    {
+        acc = (acc << count) | (bits & (uint32_t)((1ull << count) - 1));
+        n += count;
+        while (n >= 8) { n -= 8; *p++ = (uint8_t)(acc >> n); }
+    }
+    inline void ones(uint32_t count)
+    {
+        for (; count >= 16; count -= 16) { put(0xFFFF, 16); }
+        put((1u << count) - 1, (int)count);
+    }
+    inline uint8_t* flush()
+    {
+        if (n > 0) { *p++ = (uint8_t)(acc << (8 - n)); n = 0; }
+        return p;
+    }
+};
+
+struct CaptureBitReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t acc = 0;
+    int n = 0;
+    bool overrun = false;
+
+    CaptureBitReader(const uint8_t* in, const uint8_t* in_end) : p(in), end(in_end) {}
+
+    inline uint32_t get(int count) // count <= 32
+    {
+        while (n < count)
+        {
+            if (p == end) { overrun = true; return 0; }
+            acc = (acc << 8) | *p++;
+            n += 8;
+        }
+        n -= count;
+        return (uint32_t)(acc >> n) & (uint32_t)((1ull << count) - 1);
+    }
+    inline void align() { n -= n % 8; }
+};
+
+// Rice parameter from the mean zigzag difference, and the coded length in bits with it.
+// Samples: const float* or a window view (WindowSamples in WindowStorage.h).
+template <class Samples>
+static inline uint8_t capture_choose_k(Samples frames, size_t stride, size_t n, uint64_t& bits)
+{
+    uint64_t sum = 0;
+    int32_t prev = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        int32_t c = capture_quantize(frames[i * stride]);
+        sum += capture_zigzag(c - prev);
+        prev = c;
+    }
+    uint8_t k = 0;
+    while (k < 23 && ((uint64_t)n << (k + 1)) <= sum) { k++; }
+
+    bits = 0;
+    prev = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        int32_t c = capture_quantize(frames[i * stride]);
+        uint32_t q = capture_zigzag(c - prev) >> k;
+        bits += (q < CAPTURE_RICE_ESCAPE) ? q + 1 + k : CAPTURE_RICE_ESCAPE + 26;
+        prev = c;
+    }
+    return k;
+}
+
+// Packs a window of interleaved frames (volts). header.k is filled in. Returns the length,
+// at most capture_packet_max(n_frames).
+template <class Samples>
+static inline size_t capture_packet_encode(CapturePacketHeader& h, Samples frames, uint8_t* out)
+{
+    uint8_t* p = out;
+    uint8_t* body = out + CAPTURE_PACKET_HEADER;
+    for (uint8_t c = 0; c < h.channels; c++)
+    {
+        uint64_t bits;
+        uint8_t k = capture_choose_k(frames + c, h.channels, h.n_frames, bits);
+        h.k[c] = (bits > 24ull * h.n_frames) ? CAPTURE_K_RAW : k;
+
+        CaptureBitWriter w(body);
+        int32_t prev = 0;
+        for (size_t i = 0; i < h.n_frames; i++)
+        {
+            int32_t code = capture_quantize(frames[i * h.channels + c]);
+            if (h.k[c] == CAPTURE_K_RAW) { w.put((uint32_t)code, 24); continue; }
+
+            uint32_t u = capture_zigzag(code - prev);
+            uint32_t q = u >> k;
+            if (q < CAPTURE_RICE_ESCAPE)
+            {
+                w.ones(q);
+                w.put(0, 1);
+                if (k) { w.put(u, k); }
+            }
+            else
+            {
+                w.ones(CAPTURE_RICE_ESCAPE);
+                w.put(u, 26);
+            }
+            prev = code;
+        }
+        body = w.flush();
+    }
+
+    *p++ = CAPTURE_PACKET_MAGIC;
+    *p++ = CAPTURE_PACKET_VERSION;
+    memcpy(p, &h.seq, 2); p += 2;
+    memcpy(p, &h.trigger_index, 8); p += 8;
+    memcpy(p, &h.first_index, 8); p += 8;
+    memcpy(p, &h.n_frames, 2); p += 2;
+    memcpy(p, &h.sig_offset, 2); p += 2;
+    *p++ = h.timed;
+    *p++ = h.channels;
+    for (int c = 0; c < CAPTURE_MAX_CHANNELS; c++) { *p++ = h.k[c]; }
+    for (int c = 0; c < CAPTURE_MAX_CHANNELS; c++) { memcpy(p, &h.threshold[c], 4); p += 4; }
+
+    uint16_t crc = capture_crc16(out, (size_t)(body - out));
+    *body++ = (uint8_t)crc;
+    *body++ = (uint8_t)(crc >> 8);
+    return (size_t)(body - out);
+}
+
+// Unpacks a packet into interleaved frames (volts), room for max_frames. False when the
+// packet is damaged or too long.
+static inline bool capture_packet_decode(const uint8_t* in, size_t n, CapturePacketHeader& h, float* frames, size_t max_frames)
+{
+    if (n < CAPTURE_PACKET_HEADER + 2 || in[0] != CAPTURE_PACKET_MAGIC || in[1] != CAPTURE_PACKET_VERSION) { return false; }
+    uint16_t crc = (uint16_t)(in[n - 2] | (in[n - 1] << 8));
+    if (capture_crc16(in, n - 2) != crc) { return false; }
+
+    const uint8_t* p = in + 2;
+    memcpy(&h.seq, p, 2); p += 2;
+    memcpy(&h.trigger_index, p, 8); p += 8;
+    memcpy(&h.first_index, p, 8); p += 8;
+    memcpy(&h.n_frames, p, 2); p += 2;
+    memcpy(&h.sig_offset, p, 2); p += 2;
+    h.timed = *p++;
+    h.channels = *p++;
+    for (int c = 0; c < CAPTURE_MAX_CHANNELS; c++) { h.k[c] = *p++; }
+    for (int c = 0; c < CAPTURE_MAX_CHANNELS; c++) { memcpy(&h.threshold[c], p, 4); p += 4; }
+    if (h.channels == 0 || h.channels > CAPTURE_MAX_CHANNELS || h.n_frames > max_frames) { return false; }
+
+    CaptureBitReader r(p, in + n - 2);
+    for (uint8_t c = 0; c < h.channels; c++)
+    {
+        uint8_t k = h.k[c];
+        int32_t prev = 0;
+        for (size_t i = 0; i < h.n_frames; i++)
+        {
+            int32_t code;
+            if (k == CAPTURE_K_RAW) { code = (int32_t)(r.get(24) << 8) >> 8; }
+            else
+            {
+                uint32_t q = 0;
+                while (q < CAPTURE_RICE_ESCAPE && r.get(1)) { q++; }
+                uint32_t u = (q < CAPTURE_RICE_ESCAPE) ? ((q << k) | (k ? r.get(k) : 0)) : r.get(26);
+                code = prev + capture_unzigzag(u);
+            }
+            if (r.overrun) { return false; }
+            frames[i * h.channels + c] = (float)code * CAPTURE_VOLTS_PER_CODE;
+            prev = code;
+        }
+        r.align();
+    }
+    return true;
+}
+
+// COBS: out needs capture_frame_max(n) bytes. Writes the leading and trailing 0.
+static inline size_t cobs_encode(const uint8_t* in, size_t n, uint8_t* out)
+{
+    uint8_t* o = out;
+    *o++ = 0;
+    uint8_t* code = o++;
+    uint8_t run = 1;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (in[i] != 0) { *o++ = in[i]; run++; }
+        if (in[i] == 0 || run == 0xFF)
+        {
+            *code = run;
+            code = o++;
+            run = 1;
+        }
+    }
+    *code = run;
+    *o++ = 0;
+    return (size_t)(o - out);
+}
+
+// Decodes one frame without its 0 delimiters, in place is fine. Returns the length, or
+// SIZE_MAX when the frame is malformed.
+static inline size_t cobs_decode(const uint8_t* in, size_t n, uint8_t* out)
+{
+    size_t i = 0, o = 0;
+    while (i < n)
+    {
+        uint8_t run = in[i++];
+        if (run == 0 || i + run - 1 > n) { return SIZE_MAX; }
+        for (uint8_t k = 1; k < run; k++) { out[o++] = in[i++]; }
+        if (run != 0xFF && i < n) { out[o++] = 0; }
+    }
+    return o;
+}
@@ -0,0 +1,25 @@
+#include "CaptureExport.h"
+
+static uint8_t packet[CAPTURE_PACKET_HEADER + CAPTURE_MAX_CHANNELS * 3 * FRAMES_PER_SIGNAL + 2];
+static uint8_t frame[sizeof(packet) + sizeof(packet) / 254 + 3];
+
+static_assert(CHANNELS <= CAPTURE_MAX_CHANNELS, "CaptureCodec.h carries at most CAPTURE_MAX_CHANNELS channels");
+
+bool CaptureExport::send(const SignalWindow& window)
+{
+    CapturePacketHeader h;
+    h.seq = seq++;
+    h.trigger_index = window.trigger_index;
+    h.first_index = window.first_index;
+    h.n_frames = (uint16_t)window.n_frames;
+    h.sig_offset = window.sig_offset;
+    h.timed = window.timed ? 1 : 0;
+    h.channels = CHANNELS;
+    for (int c = 0; c < CAPTURE_MAX_CHANNELS; c++) { h.threshold[c] = (c < CHANNELS) ? window.threshold[c] : 0.0f; }
+
+    size_t n = cobs_encode(packet, capture_packet_encode(h, window.frames.samples(), packet), frame);
+    if ((size_t)Serial.availableForWrite() < n) { dropped++; return false; }
+    Serial.write(frame, n);
+    sent++;
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+#include "SignalWindow.h"
+#include "CaptureCodec.h"
+
+#define CAPTURE_EXPORT_BAUD 921600 // about 15 windows/s at the typical 2.2 bytes per sample
+#define CAPTURE_TX_BUFFER 16384    // UART driver TX ring, bytes; holds two worst case windows
+
+// Streams captured windows over Serial as COBS framed, Rice coded packets (CaptureCodec.h),
+// for host/capture_receiver. send() only copies the frame into the UART driver's TX ring,
+// which its interrupt drains into the FIFO, so the caller never waits on the line. A window
+// that does not fit in the ring is dropped and counted.
+class CaptureExport {
+public:
+    bool send(const SignalWindow& window);
+
+    uint32_t sent = 0;
+    uint32_t dropped = 0;
+
+private:
+    uint16_t seq = 0;
+};
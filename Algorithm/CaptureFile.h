@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Recorded captures, one file per session. Little endian, fixed size records so a
+// corpus can be memory mapped and indexed directly:
+//
+//   CaptureFileHeader
+//   n_captures x { CaptureRecord, float frames[frames * channels] }  (interleaved, volts)
+//
+// Unused frames of a short capture are zero, n_frames holds the valid count.
+
+#define CAPTURE_MAGIC 0x50435355u // "USCP"
+#define CAPTURE_VERSION 1
+
+struct CaptureFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t frames;      // frames per record
+    uint32_t reserved;
+    uint64_t n_captures;
+};
+
+struct CaptureRecord {
+    uint64_t trigger_index;
+    uint32_t n_frames;
+    uint16_t sig_offset;  // frames between the emission and the first frame
+    uint8_t timed;        // 0 when no emission time is known
+    uint8_t reserved;
+    float threshold[2];   // detection thresholds at capture time
+    float ref_angle;      // ground truth if known, else NAN (degrees)
+    float ref_distance;   // ground truth if known, else NAN (cm)
+};
+
+static_assert(sizeof(CaptureFileHeader) == 32, "CaptureFileHeader layout");
+static_assert(sizeof(CaptureRecord) == 32, "CaptureRecord layout");
+
+static inline size_t capture_record_size(const CaptureFileHeader& h)
+{
+    return sizeof(CaptureRecord) + (size_t)h.frames * h.channels * sizeof(float);
+}
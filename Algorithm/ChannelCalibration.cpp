@@ -0,0 +1,52 @@
+#include "ChannelCalibration.h"
+#include <Preferences.h>
+
+
+bool ChannelCalibration::load()
+{
+    Preferences prefs;
+    if (!prefs.begin(CALIBRATION_NVS_NAMESPACE, true)) { return false; }
+
+    ChannelCalibration stored;
+    bool ok = prefs.getBytesLength(CALIBRATION_NVS_KEY) == sizeof(stored)
+           && prefs.getBytes(CALIBRATION_NVS_KEY, &stored, sizeof(stored)) == sizeof(stored)
+           && stored.valid;
+    prefs.end();
+
+    if (ok) { *this = stored; }
+    return ok;
+}
+
+bool ChannelCalibration::save() const
+{
+    Preferences prefs;
+    if (!prefs.begin(CALIBRATION_NVS_NAMESPACE, false)) { return false; }
+    bool ok = prefs.putBytes(CALIBRATION_NVS_KEY, this, sizeof(*this)) == sizeof(*this);
+    prefs.end();
+    return ok;
+}
+
+void ChannelCorrector::configure(const ChannelCalibration& calibration, uint32_t sample_rate)
+{
+    float skew = calibration.skew_frames * SAMPLE_T_US / SampleClock{ sample_rate }.frame_us();
+    skew = fminf(CALIBRATION_MAX_SKEW, fmaxf(-CALIBRATION_MAX_SKEW, skew));
+    const float delay[CHANNELS] = { CALIBRATION_FIR_CENTER + 0.5f * skew, CALIBRATION_FIR_CENTER - 0.5f * skew };
+    const float half = 0.5f * (float)CALIBRATION_FIR_TAPS;
+
+    for (int c = 0; c < CHANNELS; c++)
+    {
+        // Hann windowed sinc centred on the channel delay, unit gain at DC before scaling.
+        float sum = 0.0f;
+        for (int k = 0; k < CALIBRATION_FIR_TAPS; k++)
+        {
+            float u = (float)k - delay[c];
+            float s = (fabsf(u) < 1e-6f) ? 1.0f : sinf((float)M_PI * u) / ((float)M_PI * u);
+            float w = (fabsf(u) < half) ? 0.5f * (1.0f + cosf((float)M_PI * u / half)) : 0.0f;
+            coeffs[c][k] = s * w;
+            sum += coeffs[c][k];
+        }
+        for (int k = 0; k < CALIBRATION_FIR_TAPS; k++) { coeffs[c][k] *= calibration.gain[c] / sum; }
+        gain[c] = calibration.gain[c];
+    }
+    enabled = calibration.valid;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <math.h>
+#include "Sampler_settings.h"
+
+#define CALIBRATION_FIR_TAPS 8 // Fractional delay FIR length per channel
+#define CALIBRATION_FIR_CENTER ((CALIBRATION_FIR_TAPS - 1) * 0.5f) // Common delay of both channels, frames
+#define CALIBRATION_MAX_SKEW 2.0f // frames, larger measured skews are clamped
+#define CALIBRATION_NVS_NAMESPACE "calib"
+#define CALIBRATION_NVS_KEY "v1"
+
+// Measured channel mismatch, stored in NVS. Identity until calibrated.
+struct ChannelCalibration {
+    float gain[CHANNELS] = { 1.0f, 1.0f };
+    float skew_frames = 0.0f;   // right channel lag behind left, frames at SAMPLE_RATE
+    float base_delay_us = 0.0f; // fixed delay between emission and arrival not due to the distance
+    bool valid = false;
+
+    bool load();
+    bool save() const;
+};
+
+// Gain and delay correction applied in Sampler::to_voltage(). Each channel runs its own
+// windowed sinc FIR: left is delayed by CALIBRATION_FIR_CENTER + skew/2, right by
+// CALIBRATION_FIR_CENTER - skew/2, so both keep the same common delay. The gain is
+// folded into the coefficients.
+class ChannelCorrector {
+public:
+    // sample_rate: the capture rate, the skew is rescaled from SAMPLE_RATE frames.
+    void configure(const ChannelCalibration& calibration, uint32_t sample_rate = SAMPLE_RATE);
+
+    // Feeds one sample of channel c and returns the corrected sample.
+    inline float process(int c, float v)
+    {
+        push(c, v);
+        const float* x = hist[c] + pos[c];
+        const float* h = coeffs[c];
+        float y = 0.0f;
+        for (int k = 0; k < CALIBRATION_FIR_TAPS; k++) { y += h[k] * x[k]; }
+        return y;
+    }
+
+    // Only updates the history, for samples that are discarded.
+    inline void push(int c, float v)
+    {
+        size_t p = pos[c] = (pos[c] == 0) ? CALIBRATION_FIR_TAPS - 1 : pos[c] - 1;
+        hist[c][p] = v;
+        hist[c][p + CALIBRATION_FIR_TAPS] = v; // Mirror, so hist[c][pos .. pos + TAPS) is the newest first.
+    }
+
+    float group_delay_us(float frame_us) const { return enabled ? CALIBRATION_FIR_CENTER * frame_us : 0.0f; }
+
+    bool enabled = false;
+    float gain[CHANNELS] = { 1.0f, 1.0f };
+
+private:
+    float coeffs[CHANNELS][CALIBRATION_FIR_TAPS];
+    float hist[CHANNELS][2 * CALIBRATION_FIR_TAPS] = {};
+    size_t pos[CHANNELS] = {};
+};
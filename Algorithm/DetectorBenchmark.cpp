@@ -0,0 +1,99 @@
+#include "DetectorBenchmark.h"
+
+#ifdef DETECTOR_BENCHMARK
+
+#include <Arduino.h>
+#include "StartDetectors.h"
+#include "SignalAnalyzer.h"
+#include "SyntheticBurst.h"
+
+// A hit more than ENERGY_WINDOW before the onset only saw noise: false alarm.
+// No hit, or none within one rise time after the onset: miss.
+struct DetectorResult {
+    uint64_t cycles = 0;
+    size_t n_samples = 0;
+    size_t n_detected = 0;
+    size_t false_alarms = 0;
+    size_t misses = 0;
+    double sum_err = 0.0; // samples, detected captures only
+};
+
+static float detector_samples[DETECTOR_BENCH_FRAMES];
+
+template <class Detector>
+static void bench_detector(const SyntheticBurst& burst, float threshold, DetectorResult& res)
+{
+    Detector det;
+    det.reset(threshold);
+    size_t start = NO_INDEX;
+
+    uint32_t c0 = ESP.getCycleCount();
+    size_t i = 0;
+    for (; i < DETECTOR_BENCH_FRAMES; i++) {
+        bool hit = det.step(i, detector_samples[i]);
+        if (hit && i + 1 >= Detector::DELAY) { start = i + 1 - Detector::DELAY; break; }
+    }
+    uint32_t c1 = ESP.getCycleCount();
+    res.cycles += (uint32_t)(c1 - c0);
+    res.n_samples += (i < DETECTOR_BENCH_FRAMES) ? i + 1 : i;
+
+    double err = (double)start - (double)burst.onset;
+    if (start == NO_INDEX || err > (double)burst.rise) { res.misses++; return; }
+    if (err < -(double)ENERGY_WINDOW) { res.false_alarms++; return; }
+    res.n_detected++;
+    res.sum_err += err;
+}
+
+static void print_result(const char* name, float amplitude, float snr_db, const DetectorResult& res)
+{
+    double n = res.n_samples ? (double)res.n_samples : 1.0;
+    double d = res.n_detected ? (double)res.n_detected : 1.0;
+    Serial.print(name); Serial.print(",");
+    Serial.print(amplitude * 1000.0f, 1); Serial.print(",");
+    Serial.print(snr_db, 1); Serial.print(",");
+    Serial.print((unsigned long)res.false_alarms); Serial.print(",");
+    Serial.print((unsigned long)res.misses); Serial.print(",");
+    Serial.print((float)(res.sum_err / d), 2); Serial.print(",");
+    Serial.println((float)((double)res.cycles / n), 1);
+}
+
+// Both detectors see the same captures and get the threshold the EWMA noise floor would
+// settle to for this noise level: ThresholdStart clamps it, CfarStart takes it as its floor.
+static void bench_snr(float amplitude, float snr_db)
+{
+    DetectorResult res_thres, res_cfar;
+    uint32_t seed = 0x9e3779b9u;
+
+    for (int b = 0; b < DETECTOR_BENCH_CAPTURES; b++) {
+        SyntheticBurst burst;
+        burst.amplitude = amplitude;
+        burst.onset = 200.0f + 400.0f * SyntheticBurst::uniform(seed);
+        burst.phase = 2.0f * (float)M_PI * SyntheticBurst::uniform(seed);
+        burst.noise_rms = amplitude / sqrtf(2.0f) * powf(10.0f, -snr_db / 20.0f);
+        burst.render(detector_samples, DETECTOR_BENCH_FRAMES, seed);
+
+        NoiseFloor noise;
+        noise.mean = burst.noise_rms * burst.noise_rms;
+        noise.var = 2.0f * noise.mean * noise.mean;
+        float threshold = SignalAnalyzer::noise_threshold(noise);
+
+        bench_detector<ThresholdStart>(burst, threshold, res_thres);
+        bench_detector<CfarStart>(burst, threshold, res_cfar);
+    }
+    print_result(ThresholdStart::NAME, amplitude, snr_db, res_thres);
+    print_result(CfarStart::NAME, amplitude, snr_db, res_cfar);
+}
+
+void run_detector_benchmark()
+{
+    const float amplitudes[] = { 0.001f, 0.01f, 0.1f }; // V, quiet to loud
+    const float snrs[] = { -6.0f, 0.0f, 6.0f, 12.0f, 20.0f, 30.0f, 40.0f }; // dB
+
+    Serial.println("detector,amplitude_mv,snr_db,false_alarms,misses,mean_delay,cycles_per_sample");
+    for (float amplitude : amplitudes) {
+        for (float snr_db : snrs) { bench_snr(amplitude, snr_db); }
+    }
+    Serial.flush();
+}
+
+#endif
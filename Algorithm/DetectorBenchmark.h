@@ -0,0 +1,10 @@
+#pragma once
+
+//#define DETECTOR_BENCHMARK // Run the start detector benchmark from setup() instead of measuring.
+
+#define DETECTOR_BENCH_CAPTURES 200 // per amplitude and SNR
+#define DETECTOR_BENCH_FRAMES 1024
+
+#ifdef DETECTOR_BENCHMARK
+void run_detector_benchmark();
+#endif
@@ -0,0 +1,292 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "Solver.h"
+
+// One pairwise time difference: arrival at microphone b minus arrival at microphone a, as
+// Solver::solve() returns it for a window with a as L and b as R.
+struct TdoaPair {
+    uint8_t a, b;
+    float t_diff;        // us
+    float weight = 1.0f; // relative, e.g. Measurement::confidence
+};
+
+struct Direction {
+    float azimuth = NAN;     // degrees from forward (+y), positive towards the left (-x), as Solver::calc_angle()
+    float elevation = NAN;   // degrees above the x, y plane
+    float residual_us = NAN; // weighted rms of the pairs against the solved direction
+    int rank = 0;            // dimensions the pairs observe: 1 for a line array, 2 planar, 3 otherwise
+    int slipped = 0;         // pairs moved by whole slip periods (DirectionSolver::slip_us)
+};
+
+// Far field direction of arrival from the time differences of any pairs of N microphones,
+// positions in m (x right, y forward, z up). Each pair gives t_b - t_a = -(p_b - p_a) . u / c
+// for the unit vector u towards the source; solve() fits the slowness u / c to all pairs by
+// weighted least squares. Fixed size: the 3 x 3 normal equations are summed over at most
+// N * (N - 1) / 2 pairs and solved through their eigen decomposition, so the cost is linear
+// in the pairs and nothing is allocated.
+//
+// A line or planar array does not observe every component. The missing part is filled
+// from the constraint |u| = 1, on the side of prior: forward by default, so one pair
+// returns the azimuth of Solver::calc_angle() at elevation 0, and a horizontal planar array
+// returns sources above it.
+//
+// With slip_us set, a pair may be off by up to SLIP_MAX whole periods, as Solver is when it
+// matches the peaks one carrier cycle apart. When the pairs observe all three components and
+// there are at most SLIP_SEARCH_PAIRS of them, solve() tries every combination of slips and
+// keeps the one that best fits a slowness of length 1 / c, with SLIP_PENALTY per slipped
+// pair. The normal equations do not depend on the slips, so each combination only moves the
+// least squares slowness by a precomputed step: 5^6 combinations for four microphones.
+// Some slips of whole microphones fit another direction as well as the true one; those
+// cannot be told apart and come out a few degrees off.
+template <int N>
+class DirectionSolver {
+    public:
+    static_assert(N >= 2 && N <= 255, "DirectionSolver needs 2 to 255 microphones");
+    static constexpr size_t MAX_PAIRS = (size_t)N * (N - 1) / 2;
+
+    DirectionSolver(const float (&positions)[N][3])
+    {
+        for (int i = 0; i < N; i++) { for (int k = 0; k < 3; k++) { pos[i][k] = positions[i][k]; } }
+    }
+
+    float prior[3] = { 0.0f, 1.0f, 0.0f }; // side of the unobserved components, need not be unit
+    float slip_us = 0.0f; // period the pairs may be off by whole multiples of, e.g. 1e6f / CARRIER_HZ; 0 trusts them
+
+    bool solve(const TdoaPair* pairs, size_t n_pairs, Direction& d) const
+    {
+        d.slipped = 0;
+        if (slip_us > 0.0f && n_pairs <= SLIP_SEARCH_PAIRS)
+        {
+            TdoaPair unslipped[SLIP_SEARCH_PAIRS];
+            int slipped = unslip(pairs, n_pairs, unslipped);
+            if (slipped > 0)
+            {
+                bool ok = solve_pairs(unslipped, n_pairs, d);
+                d.slipped = slipped;
+                return ok;
+            }
+        }
+        return solve_pairs(pairs, n_pairs, d);
+    }
+
+    private:
+    static constexpr float RANK_EPS = 1e-4f;  // eigenvalues below this share of the largest are unobserved
+    static constexpr int JACOBI_SWEEPS = 8;   // a 3 x 3 converges to float precision in 4 or 5
+    static constexpr size_t SLIP_SEARCH_PAIRS = 6; // all pairs of four microphones
+    static constexpr int SLIP_MAX = 2;             // periods a pair may be off either way
+    static constexpr float SLIP_RESIDUAL_US = 0.1f; // residual rms of a consistent set, the cost unit
+    static constexpr float SLIP_NORM_TOL = 5e-4f;   // relative error of |slowness| worth one cost unit
+    static constexpr float SLIP_PENALTY = 1.0f;     // cost of each slipped pair
+
+    bool solve_pairs(const TdoaPair* pairs, size_t n_pairs, Direction& d) const
+    {
+        const float slowness = 1e6f / SOUND_SPEED; // us per m along u
+        float M[3][3], v[3];
+        if (!normal_equations(pairs, n_pairs, M, v)) { return false; }
+
+        float lambda[3], V[3][3];
+        eigen_sym3(M, lambda, V);
+        float lambda_max = fmaxf(lambda[0], fmaxf(lambda[1], lambda[2]));
+        if (!(lambda_max > 0.0f)) { return false; }
+
+        // Least squares slowness in the observed eigen directions; the prior in the others.
+        float s[3] = {}, q[3] = {}, z_null[3] = {};
+        d.rank = 0;
+        for (int e = 0; e < 3; e++)
+        {
+            float ve[3] = { V[0][e], V[1][e], V[2][e] };
+            if (lambda[e] > RANK_EPS * lambda_max)
+            {
+                d.rank++;
+                float c = dot(ve, v) / lambda[e];
+                for (int i = 0; i < 3; i++) { s[i] += c * ve[i]; }
+            }
+            else
+            {
+                float c = dot(ve, prior);
+                for (int i = 0; i < 3; i++) { q[i] += c * ve[i]; }
+                if (fabsf(ve[2]) > fabsf(z_null[2])) { for (int i = 0; i < 3; i++) { z_null[i] = (ve[2] < 0.0f) ? -ve[i] : ve[i]; } }
+            }
+        }
+        if (d.rank < 3)
+        {
+            // prior square to the unobserved directions (a horizontal array, prior forward): up.
+            if (dot(q, q) < 1e-12f) { for (int i = 0; i < 3; i++) { q[i] = z_null[i]; } }
+            float q_norm = sqrtf(dot(q, q));
+            float fill = slowness * slowness - dot(s, s);
+            float alpha = (fill > 0.0f && q_norm > 0.0f) ? sqrtf(fill) / q_norm : 0.0f;
+            for (int i = 0; i < 3; i++) { s[i] += alpha * q[i]; }
+        }
+
+        float s_norm = sqrtf(dot(s, s));
+        if (!(s_norm > 0.0f)) { return false; }
+        float u[3] = { s[0] / s_norm, s[1] / s_norm, s[2] / s_norm };
+        d.azimuth = atan2f(-u[0], u[1]) * RAD_TO_DEG;
+        d.elevation = asinf(fminf(1.0f, fmaxf(-1.0f, u[2]))) * RAD_TO_DEG;
+
+        float r2 = 0.0f, w = 0.0f;
+        for (size_t k = 0; k < n_pairs; k++)
+        {
+            float b[3];
+            baseline(pairs[k], b);
+            float r = pairs[k].t_diff + slowness * dot(b, u);
+            r2 += pairs[k].weight * r * r;
+            w += pairs[k].weight;
+        }
+        d.residual_us = (w > 0.0f) ? sqrtf(r2 / w) : NAN;
+        return true;
+    }
+
+    // Sums the weighted normal equations M s = v of the pairs. False on an invalid pair.
+    bool normal_equations(const TdoaPair* pairs, size_t n_pairs, float (&M)[3][3], float (&v)[3]) const
+    {
+        for (int i = 0; i < 3; i++) { v[i] = 0.0f; for (int j = 0; j < 3; j++) { M[i][j] = 0.0f; } }
+        for (size_t k = 0; k < n_pairs; k++)
+        {
+            const TdoaPair& p = pairs[k];
+            if (p.a >= N || p.b >= N || p.a == p.b) { return false; }
+            float b[3];
+            baseline(p, b);
+            for (int i = 0; i < 3; i++)
+            {
+                v[i] -= p.weight * b[i] * p.t_diff;
+                for (int j = 0; j < 3; j++) { M[i][j] += p.weight * b[i] * b[j]; }
+            }
+        }
+        return true;
+    }
+
+    // Copies the pairs to out with the slips of the best combination taken off. Returns the
+    // number of slipped pairs, 0 when none or when the pairs do not observe all three components.
+    int unslip(const TdoaPair* pairs, size_t n_pairs, TdoaPair* out) const
+    {
+        const float slowness = 1e6f / SOUND_SPEED;
+        float M[3][3], v[3], lambda[3], V[3][3];
+        if (!normal_equations(pairs, n_pairs, M, v)) { return 0; }
+        eigen_sym3(M, lambda, V);
+        float lambda_max = fmaxf(lambda[0], fmaxf(lambda[1], lambda[2]));
+        for (int e = 0; e < 3; e++) { if (!(lambda[e] > RANK_EPS * lambda_max)) { return 0; } }
+
+        // s = Minv v; one more period on pair k adds step[k] to s.
+        float Minv[3][3];
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                Minv[i][j] = 0.0f;
+                for (int e = 0; e < 3; e++) { Minv[i][j] += V[i][e] * V[j][e] / lambda[e]; }
+            }
+        }
+        float s[3], b[SLIP_SEARCH_PAIRS][3], step[SLIP_SEARCH_PAIRS][3], w = 0.0f;
+        for (int i = 0; i < 3; i++) { s[i] = dot(Minv[i], v); }
+        for (size_t k = 0; k < n_pairs; k++)
+        {
+            baseline(pairs[k], b[k]);
+            for (int i = 0; i < 3; i++) { step[k][i] = -pairs[k].weight * slip_us * dot(Minv[i], b[k]); }
+            w += pairs[k].weight;
+        }
+        if (!(w > 0.0f)) { return 0; }
+
+        // Every combination in turn, an odometer over the pairs from -SLIP_MAX to SLIP_MAX, s
+        // moved along with it.
+        int slip[SLIP_SEARCH_PAIRS], best[SLIP_SEARCH_PAIRS] = {};
+        for (size_t k = 0; k < n_pairs; k++)
+        {
+            slip[k] = -SLIP_MAX;
+            for (int i = 0; i < 3; i++) { s[i] -= SLIP_MAX * step[k][i]; }
+        }
+        float best_cost = INFINITY;
+        while (true)
+        {
+            float r2 = 0.0f;
+            int n_slipped = 0;
+            for (size_t k = 0; k < n_pairs; k++)
+            {
+                float r = pairs[k].t_diff + (float)slip[k] * slip_us + dot(b[k], s);
+                r2 += pairs[k].weight * r * r;
+                n_slipped += (slip[k] != 0);
+            }
+            float norm_err = (sqrtf(dot(s, s)) / slowness - 1.0f) / SLIP_NORM_TOL;
+            float cost = r2 / w / (SLIP_RESIDUAL_US * SLIP_RESIDUAL_US) + norm_err * norm_err + SLIP_PENALTY * (float)n_slipped;
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                for (size_t k = 0; k < n_pairs; k++) { best[k] = slip[k]; }
+            }
+
+            size_t k = 0;
+            while (k < n_pairs && slip[k] == SLIP_MAX)
+            {
+                slip[k] = -SLIP_MAX;
+                for (int i = 0; i < 3; i++) { s[i] -= 2 * SLIP_MAX * step[k][i]; }
+                k++;
+            }
+            if (k == n_pairs) { break; }
+            slip[k]++;
+            for (int i = 0; i < 3; i++) { s[i] += step[k][i]; }
+        }
+
+        int n_slipped = 0;
+        for (size_t k = 0; k < n_pairs; k++)
+        {
+            out[k] = pairs[k];
+            out[k].t_diff += (float)best[k] * slip_us;
+            n_slipped += (best[k] != 0);
+        }
+        return n_slipped;
+    }
+
+    static inline float dot(const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+    inline void baseline(const TdoaPair& p, float* b) const
+    {
+        for (int i = 0; i < 3; i++) { b[i] = pos[p.b][i] - pos[p.a][i]; }
+    }
+
+    // Cyclic Jacobi: A = V diag(lambda) V^T, eigenvectors in the columns of V.
+    static void eigen_sym3(const float (&M)[3][3], float* lambda, float (&V)[3][3])
+    {
+        float A[3][3];
+        for (int i = 0; i < 3; i++) { for (int j = 0; j < 3; j++) { A[i][j] = M[i][j]; V[i][j] = (i == j) ? 1.0f : 0.0f; } }
+
+        for (int sweep = 0; sweep < JACOBI_SWEEPS; sweep++)
+        {
+            float off = A[0][1] * A[0][1] + A[0][2] * A[0][2] + A[1][2] * A[1][2];
+            float diag = A[0][0] * A[0][0] + A[1][1] * A[1][1] + A[2][2] * A[2][2];
+            if (off <= 1e-14f * diag) { break; }
+            for (int p = 0; p < 2; p++)
+            {
+                for (int r = p + 1; r < 3; r++)
+                {
+                    if (A[p][r] == 0.0f) { continue; }
+                    float theta = (A[r][r] - A[p][p]) / (2.0f * A[p][r]);
+                    float t = copysignf(1.0f, theta) / (fabsf(theta) + sqrtf(theta * theta + 1.0f));
+                    float c = 1.0f / sqrtf(t * t + 1.0f), sn = t * c;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        float akp = A[k][p], akr = A[k][r];
+                        A[k][p] = c * akp - sn * akr;
+                        A[k][r] = sn * akp + c * akr;
+                    }
+                    for (int k = 0; k < 3; k++)
+                    {
+                        float apk = A[p][k], ark = A[r][k];
+                        A[p][k] = c * apk - sn * ark;
+                        A[r][k] = sn * apk + c * ark;
+                    }
+                    for (int k = 0; k < 3; k++)
+                    {
+                        float vkp = V[k][p], vkr = V[k][r];
+                        V[k][p] = c * vkp - sn * vkr;
+                        V[k][r] = sn * vkp + c * vkr;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < 3; i++) { lambda[i] = A[i][i]; }
+    }
+
+    float pos[N][3];
+};
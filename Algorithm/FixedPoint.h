@@ -0,0 +1,77 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+
+// Fixed point formats of the integer analysis pipeline (FixedSolver.h):
+//   Q31  window samples, the I2S slot as the converter delivers it. 1.0 is the peak full
+//        scale of code_to_voltage(), Q31_VOLTS.
+//   Q23  the 24 significant bits of a Q31 sample. Squares are Q46 and sum exactly in
+//        int64, for the energy detectors and the region energy.
+//   Q15  normalized samples, peak values, sample offsets and correlations, held in int32
+//        so that 1.0 and short sums fit.
+typedef int32_t q31_t;
+
+static constexpr float Q31_VOLTS = 2.0f * 1.41421356237f; // volts of 1.0
+static constexpr float Q31_ONE = 2147483648.0f;
+static constexpr int32_t Q15_ONE = 1 << 15;
+
+static inline q31_t q31_sat(int64_t v)
+{
+    if (v > INT32_MAX) { return INT32_MAX; }
+    if (v < INT32_MIN) { return INT32_MIN; }
+    return (q31_t)v;
+}
+
+static inline q31_t q31_from_volts(float v)
+{
+    float c = v * (Q31_ONE / Q31_VOLTS);
+    if (c >= Q31_ONE) { return INT32_MAX; }
+    if (c <= -Q31_ONE) { return INT32_MIN; }
+    return (q31_t)lrintf(c);
+}
+
+static inline float q31_to_volts(q31_t v) { return (float)v * (Q31_VOLTS / Q31_ONE); }
+
+// Energies in V^2 as sums of Q23 squares, for thresholds given in volts.
+static constexpr int64_t q46_from_volts2(float e) { return (int64_t)((double)e / ((double)Q31_VOLTS * Q31_VOLTS) * 70368744177664.0 + 0.5); } // 2^46
+static constexpr double Q46_VOLTS2 = (double)Q31_VOLTS * Q31_VOLTS / 70368744177664.0;
+
+static inline int64_t q23_square(q31_t v)
+{
+    int32_t s = v >> 8;
+    return (int64_t)s * s;
+}
+
+static inline int clz64(uint64_t v) { return v ? __builtin_clzll(v) : 64; }
+
+static inline uint32_t isqrt64(uint64_t v)
+{
+    if (v == 0) { return 0; }
+    uint64_t r = 0;
+    for (uint64_t bit = (uint64_t)1 << ((63 - clz64(v)) & ~1); bit; bit >>= 2)
+    {
+        if (v >= r + bit) { v -= r + bit; r = (r >> 1) + bit; }
+        else { r >>= 1; }
+    }
+    return (uint32_t)r;
+}
+
+// (num * 2^frac) / den, truncated. num is shifted left as far as it fits and den right by
+// the rest, so precision is only lost when den is wider than 63 - frac bits. Saturates.
+static inline int64_t q_div64(int64_t num, int64_t den, int frac)
+{
+    bool neg = (num < 0) != (den < 0);
+    uint64_t n = (num < 0) ? 0 - (uint64_t)num : (uint64_t)num;
+    uint64_t d = (den < 0) ? 0 - (uint64_t)den : (uint64_t)den;
+
+    int up = clz64(n) - 1;
+    if (up > frac) { up = frac; }
+    if (up < 0) { up = 0; }
+    n <<= up;
+    d >>= frac - up;
+    if (d == 0) { return neg ? INT64_MIN : INT64_MAX; }
+
+    uint64_t q = n / d;
+    if (q > (uint64_t)INT64_MAX) { q = INT64_MAX; }
+    return neg ? -(int64_t)q : (int64_t)q;
+}
@@ -0,0 +1,239 @@
+#include "FixedSolver.h"
+
+#define TIE_EPS_Q30 107374 // 1e-4 of Solver::find_peak_diff
+
+static inline float q15_frames_to_us(int64_t t, float frame_us) { return (float)t * (frame_us / (float)Q15_ONE); }
+
+bool FixedSolver::solve(const q31_t* frames, size_t n_frames, float& t_diff, float& sig_delay, Measurement& m)
+{
+    PROFILE_SCOPE(PROF_SOLVE);
+    const size_t n_peaks = params.n_peaks;
+    sig = frames;
+    stereo_analyzer.set_buffer(frames);
+    peak_interpolator_l.set_buffer(frames);
+    peak_interpolator_r.set_buffer(frames + 1);
+
+    size_t signal_start_l, est_peaks_l[N_PEAKS];
+    size_t signal_start_r, est_peaks_r[N_PEAKS];
+    {
+        PROFILE_SCOPE_INTO(PROF_ANALYZE, m.timing.analyze);
+        if (!stereo_analyzer.analyze<FIXED_START_DETECTOR>(n_frames, signal_start_l, est_peaks_l, signal_start_r, est_peaks_r)) { LOG(LOG_FAILED_ANALYZER); return false; }
+    }
+
+    {
+        PROFILE_SCOPE_INTO(PROF_NORMALIZE, m.timing.normalize);
+        RegionQ31 region_l, region_r;
+        normalize(n_frames, n_peaks, est_peaks_l, est_peaks_r, region_l, region_r);
+        peak_interpolator_l.set_scale(region_l);
+        peak_interpolator_r.set_scale(region_r);
+    }
+
+    int32_t peaks_l[N_PEAKS], time_l[N_PEAKS]; // Q15, Q15 frames
+    int32_t peaks_r[N_PEAKS], time_r[N_PEAKS];
+    {
+        PROFILE_SCOPE_INTO(PROF_INTERPOLATE, m.timing.interpolate);
+        if (!peak_interpolator_l.interpolate_peaks<PeakPolicy>(n_frames, n_peaks, est_peaks_l, peaks_l, time_l)) { LOG(LOG_FAILED_INTERP_L); return false; }
+        if (!peak_interpolator_r.interpolate_peaks<PeakPolicy>(n_frames, n_peaks, est_peaks_r, peaks_r, time_r)) { LOG(LOG_FAILED_INTERP_R); return false; }
+    }
+
+    {
+        PROFILE_SCOPE_INTO(PROF_CORRELATE, m.timing.correlate);
+        int32_t dt, confidence;
+        find_peak_diff(peaks_l, time_l, peaks_r, time_r, dt, confidence);
+        t_diff = q15_frames_to_us(dt, frame_us);
+        m.confidence = (float)confidence / (float)Q15_ONE;
+    }
+
+    {
+        PROFILE_SCOPE_INTO(PROF_LINE_FIT, m.timing.line_fit);
+        sig_delay = q15_frames_to_us(find_sig_delay(peaks_l, time_l, peaks_r, time_r, n_peaks), frame_us);
+    }
+
+    return true;
+}
+
+// Normalized correlation in Q30, from Q15 samples. Q30 so that near ties between lags
+// resolve as in float. The sums are 32 bit: each product is of Q14 samples, which holds
+// peaks up to 2.0, and is kept to Q23 so N_PEAKS of them fit. One float division per lag
+// normalizes them, no 64 bit divides or square roots in software.
+static_assert(N_PEAKS <= 32, "the Q23 correlation sums hold 32 products");
+
+static inline int32_t corr_norm_q30(const int32_t* a, const int32_t* b, int n)
+{
+    int32_t num = 0, da = 0, db = 0;
+    for (int i = 0; i < n; ++i) {
+        int32_t x = a[i] >> 1;
+        int32_t y = b[i] >> 1;
+        num += (x * y) >> CORR_SUM_SHIFT;
+        da  += (x * x) >> CORR_SUM_SHIFT;
+        db  += (y * y) >> CORR_SUM_SHIFT;
+    }
+    if (da <= 0 || db <= 0) return -(1 << 30);
+    return (int32_t)((float)num / sqrtf((float)da * (float)db) * (float)(1 << 30));
+}
+
+// Solver::find_peak_diff: the peak lag with the best correlation, then the median time
+// difference of the aligned peaks (Q15 frames).
+void FixedSolver::find_peak_diff(const int32_t* peaks_l, const int32_t* time_l,
+                                 const int32_t* peaks_r, const int32_t* time_r,
+                                 int32_t& t_diff, int32_t& confidence)
+{
+    const int N = (int)params.n_peaks;
+
+    int L = (int)params.peak_lag;
+    if (L > N - 1) L = N - 1;
+    const int W = N - L;
+
+    int bestLag = 0;
+    int32_t bestCorr = INT32_MIN;
+
+    for (int lag = -L; lag <= L; ++lag)
+    {
+        int i0 = (lag < 0) ? -lag : 0;
+        if (i0 + W > N) continue;
+
+        int32_t c = corr_norm_q30(peaks_l + i0, peaks_r + i0 + lag, W);
+
+        if ((int64_t)c > (int64_t)bestCorr + TIE_EPS_Q30 ||
+            (llabs((int64_t)c - bestCorr) <= TIE_EPS_Q30 && abs(lag) < abs(bestLag)))
+        {
+            bestCorr = c;
+            bestLag = lag;
+        }
+    }
+
+    confidence = (bestCorr > 0) ? bestCorr >> 15 : 0; // Q15
+
+    int32_t dt[N_PEAKS];
+    int n_dt = 0;
+
+    if (bestLag >= 0) {
+        for (int i = 0; i + bestLag < N; ++i) {
+            dt[n_dt++] = time_r[i + bestLag] - time_l[i];  // R - L
+        }
+    } else {
+        int k = -bestLag;
+        for (int i = 0; i + k < N; ++i) {
+            dt[n_dt++] = time_r[i] - time_l[i + k];        // R - L
+        }
+    }
+
+    for (int i = 0; i < n_dt - 1; ++i) {
+        int mi = i;
+        for (int j = i + 1; j < n_dt; ++j) if (dt[j] < dt[mi]) mi = j;
+        if (mi != i) { int32_t tmp = dt[i]; dt[i] = dt[mi]; dt[mi] = tmp; }
+    }
+
+    if (n_dt <= 0) { t_diff = 0; return; }
+
+    if (n_dt & 1) t_diff = dt[n_dt / 2];
+    else          t_diff = (dt[n_dt/2 - 1] + dt[n_dt/2]) / 2;
+}
+
+// Shortest of the two envelope starts, Q15 frames.
+int64_t FixedSolver::find_sig_delay(const int32_t* peaks_l, const int32_t* time_l, const int32_t* peaks_r, const int32_t* time_r, size_t n_peaks)
+{
+    // A degenerate fit (no rise) falls back to the first peak.
+    int64_t start_l = time_l[0], start_r = time_r[0];
+    fit_intercept(time_l, peaks_l, (int)n_peaks, start_l);
+    fit_intercept(time_r, peaks_r, (int)n_peaks, start_r);
+    return (start_l < start_r) ? start_l : start_r;
+}
+
+// Where the least squares line through (t, peaks) crosses zero, Q15 frames. The sums are
+// 32 bit: the times relative to the first peak are shifted to at most FIT_TIME_BITS bits,
+// the peaks to Q12, so N_PEAKS squares and products fit. The solve at the end is in int64,
+// once per channel. With slope a = S / D: t0 = (T - Y / a) / n = (T - Y * (D / S)) / n.
+static_assert(N_PEAKS <= 64, "the 32 bit line fit sums hold 64 points");
+
+bool FixedSolver::fit_intercept(const int32_t* t, const int32_t* peaks, int n_peaks, int64_t& t0)
+{
+    if (n_peaks < 2) { return false; }
+
+    int32_t span = t[n_peaks - 1] - t[0];
+    if (span <= 0) { return false; }
+    int shift = (64 - clz64((uint64_t)span)) - FIT_TIME_BITS;
+    if (shift < 0) { shift = 0; }
+
+    int32_t T = 0, Y = 0, TT = 0, TY = 0;
+    for (int i = 0; i < n_peaks; ++i) {
+        int32_t ti = (t[i] - t[0]) >> shift;
+        int32_t yi = peaks[i] >> FIT_PEAK_SHIFT;
+        T  += ti;
+        Y  += yi;
+        TT += ti * ti;
+        TY += ti * yi;
+    }
+
+    int64_t D = (int64_t)n_peaks * TT - (int64_t)T * T;
+    int64_t S = (int64_t)n_peaks * TY - (int64_t)T * Y;
+    if (D <= 0 || S == 0) { return false; } // vertical or flat, no good.
+
+    int64_t r = q_div64(D, S, FIT_RATIO_BITS); // 1 / a
+    int64_t y_abs = (Y < 0) ? -(int64_t)Y : Y;
+    if (y_abs > 0 && (r > INT64_MAX / y_abs || r < -(INT64_MAX / y_abs))) { return false; } // nearly flat
+
+    int64_t rel = ((int64_t)T * ((int64_t)1 << FIT_RATIO_BITS) - Y * r) / n_peaks; // t units, FIT_RATIO_BITS more fraction
+    t0 = t[0] + ((rel * ((int64_t)1 << shift)) >> FIT_RATIO_BITS);
+    return true;
+}
+
+// Running sums for one channel of the normalization region, as Solver's RegionAccumulator.
+struct RegionAccumulatorQ31 {
+    int64_t sum = 0;
+    int64_t sum2 = 0; // Q46
+    q31_t min = INT32_MAX;
+    q31_t max = INT32_MIN;
+
+    inline void add(q31_t v)
+    {
+        sum += v;
+        sum2 += q23_square(v);
+        if (v < min) { min = v; }
+        if (v > max) { max = v; }
+    }
+
+    void finish(RegionStats& stats, RegionQ31& region) const
+    {
+        size_t n = stats.end - stats.start;
+        if (n == 0) { stats = RegionStats(); region = RegionQ31(); return; }
+
+        q31_t dc = (q31_t)(sum / (int64_t)n);
+        int64_t abs_max = ((int64_t)max - dc > (int64_t)dc - min) ? (int64_t)max - dc : (int64_t)dc - min;
+
+        region = RegionQ31();
+        region.dc = dc;
+        if (abs_max > 0)
+        {
+            int b = 63 - clz64((uint64_t)abs_max);  // abs_max in [2^b, 2^(b + 1))
+            region.shift = b + 16;                    // gain in (2^30, 2^31]
+            uint64_t gain = ((uint64_t)1 << (15 + region.shift)) / (uint64_t)abs_max;
+            region.gain = (gain > INT32_MAX) ? INT32_MAX : (int32_t)gain;
+        }
+
+        // Volts, for the calibration.
+        int64_t dc23 = dc >> 8;
+        stats.dc = q31_to_volts(dc);
+        stats.abs_max = (float)abs_max * (Q31_VOLTS / Q31_ONE);
+        stats.energy = fmaxf(0.0f, (float)((double)(sum2 - (int64_t)n * dc23 * dc23) * Q46_VOLTS2));
+        stats.gain = (stats.abs_max > 1e-12f) ? 1.0f / stats.abs_max : 1.0f;
+    }
+};
+
+void FixedSolver::normalize(size_t n_frames, size_t n_peaks, const size_t* est_peaks_l, const size_t* est_peaks_r, RegionQ31& region_l, RegionQ31& region_r)
+{
+    peak_region(n_frames, n_peaks, est_peaks_l, stats_l);
+    peak_region(n_frames, n_peaks, est_peaks_r, stats_r);
+
+    size_t begin = (stats_l.start < stats_r.start) ? stats_l.start : stats_r.start;
+    size_t end = (stats_l.end > stats_r.end) ? stats_l.end : stats_r.end;
+
+    RegionAccumulatorQ31 acc_l, acc_r;
+    for (size_t i = begin; i < end; i++) {
+        if (i >= stats_l.start && i < stats_l.end) { acc_l.add(sig[i * CHANNELS]); }
+        if (i >= stats_r.start && i < stats_r.end) { acc_r.add(sig[i * CHANNELS + 1]); }
+    }
+
+    acc_l.finish(stats_l, region_l);
+    acc_r.finish(stats_r, region_r);
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "Solver.h"
+#include "FixedPoint.h"
+
+#define FIXED_START_DETECTOR CfarStartQ31 // ThresholdStartQ31, CfarStartQ31
+#ifndef FIXED_PEAK_INTERPOLATION_POLICY
+#define FIXED_PEAK_INTERPOLATION_POLICY SincTablePeakQ15 // ParabolicPeakQ15, SincTablePeakQ15
+#endif
+#define CORR_SUM_SHIFT 5   // Q28 products of two Q14 peaks to the Q23 of the correlation sums
+#define FIT_TIME_BITS 12   // bits of the peak times in the line fit, relative to the first peak
+#define FIT_PEAK_SHIFT 3   // Q15 peaks to the Q12 of the line fit
+#define FIT_RATIO_BITS 24  // fraction bits of 1 / slope in the line fit
+
+// Normalization of one peak region: ((x - dc) * gain) >> shift is Q15, 1.0 at abs_max.
+struct RegionQ31 {
+    q31_t dc = 0;
+    int32_t gain = 0;
+    int shift = 0;
+
+    inline int32_t normalize(q31_t x) const { return (int32_t)(((int64_t)q31_sat((int64_t)x - dc) * gain) >> shift); }
+};
+
+// PeakInterpolator for Q31 samples and the Q15 policies (PeakPolicies.h). Peak values
+// are Q15, times Q15 frames.
+class FixedPeakInterpolator {
+    public:
+    // stride: distance between two samples of this channel, CHANNELS for interleaved frames.
+    FixedPeakInterpolator(size_t stride = 1) : stride(stride) {}
+
+    void set_buffer(const q31_t* sample_buffer) { samples = sample_buffer; }
+    void set_scale(const RegionQ31& region) { this->region = region; }
+
+    template <class Policy>
+    bool interpolate_peaks(size_t n_samples, size_t n_peaks, const size_t* est_peaks, int32_t* peaks, int32_t* time)
+    {
+        int32_t x[2 * Policy::REACH + 1];
+        for (size_t j = 0; j < n_peaks; j++)
+        {
+            size_t index = est_peaks[j];
+            if (index < (size_t)Policy::REACH || index + Policy::REACH >= n_samples) { return false; }
+
+            for (int m = -Policy::REACH; m <= Policy::REACH; m++) {
+                x[m + Policy::REACH] = region.normalize(samples[(index + m) * stride]);
+            }
+
+            int32_t delta;
+            if (!Policy::refine(x + Policy::REACH, delta, peaks[j])) { return false; }
+            time[j] = (int32_t)(index << 15) + delta; // n_samples < 2^16
+        }
+        return true;
+    }
+
+    private:
+    const q31_t* samples = nullptr;
+    size_t stride;
+    RegionQ31 region;
+};
+
+// Solver in integer arithmetic, on Q31 windows (FIXED_POINT_PIPELINE, see WindowStorage.h).
+// Same chain and the same interface: start and peak detection on exact int64 energies,
+// Q15 normalization, interpolation, correlation and line fit. The correlation and line fit
+// sum in 32 bits and normalize once at the end, a float division per lag and an int64
+// solve per channel. Only that, the results, and the region statistics kept for the
+// calibration are float.
+// host/fixed_compare checks it against Solver over a capture corpus.
+//
+// Not a speed option yet. The start detectors and the region normalization still multiply
+// in int64, which the ESP32's 32 bit core does in software. On the host it is about as fast
+// as Solver (0.8 to 0.95x in fixed_compare), and it has not been timed on a board. Run
+// SOLVE_BENCHMARK, which prints q31_speedup per capture, before choosing it for speed.
+class FixedSolver {
+    public:
+    FixedSolver()
+    : analyzer_l(nullptr, CHANNELS),
+    analyzer_r(nullptr, CHANNELS),
+    stereo_analyzer(nullptr, analyzer_l, analyzer_r, MAX_CHANNEL_LAG, params),
+    peak_interpolator_l(CHANNELS),
+    peak_interpolator_r(CHANNELS) {}
+
+    typedef FIXED_PEAK_INTERPOLATION_POLICY PeakPolicy;
+
+    // Detection thresholds of the window in V^2, as Solver::set_thresholds.
+    void set_thresholds(const float* thresholds)
+    {
+        analyzer_l.signal_threshold = thresholds[0];
+        analyzer_r.signal_threshold = thresholds[1];
+    }
+
+    // Capture rate of the window, as Solver::set_sample_rate.
+    void set_sample_rate(uint32_t hz) { frame_us = SampleClock{ hz }.frame_us(); }
+
+    // frames: n_frames interleaved L, R frames, Q31, n_frames < 2^16. t_diff (R - L) and
+    // sig_delay in us.
+    bool solve(const q31_t* frames, size_t n_frames, float& t_diff, float& sig_delay, Measurement& m);
+    bool solve(Q31Samples frames, size_t n_frames, float& t_diff, float& sig_delay, Measurement& m) { return solve(frames.q31, n_frames, t_diff, sig_delay, m); }
+
+    RegionStats stats_l, stats_r; // Peak regions of the last solve(), in volts
+    AnalysisParams params = TUNED_ANALYSIS_PARAMS; // Must stay valid(), read by every solve()
+
+    private:
+    void find_peak_diff(const int32_t* peaks_l, const int32_t* time_l, const int32_t* peaks_r, const int32_t* time_r, int32_t& t_diff, int32_t& confidence);
+    int64_t find_sig_delay(const int32_t* peaks_l, const int32_t* time_l, const int32_t* peaks_r, const int32_t* time_r, size_t n_peaks);
+    void normalize(size_t n_frames, size_t n_peaks, const size_t* est_peaks_l, const size_t* est_peaks_r, RegionQ31& region_l, RegionQ31& region_r);
+    bool fit_intercept(const int32_t* t, const int32_t* peaks, int n_peaks, int64_t& t0);
+
+    const q31_t* sig = nullptr; // Window being analysed, interleaved L, R frames.
+    float frame_us = SAMPLE_T_US;
+
+    SignalAnalyzer analyzer_l;
+    SignalAnalyzer analyzer_r;
+    BasicStereoAnalyzer<const q31_t*> stereo_analyzer;
+    FixedPeakInterpolator peak_interpolator_l;
+    FixedPeakInterpolator peak_interpolator_r;
+};
+
+// The solver the firmware runs on its windows.
+#ifdef FIXED_POINT_PIPELINE
+typedef FixedSolver WindowSolver;
+#else
+typedef Solver WindowSolver;
+#endif
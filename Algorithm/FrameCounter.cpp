@@ -1,5 +1,6 @@
 // FrameCounter.cpp
 #include "FrameCounter.h"
+#include "Trace.h"
 #include "esp_err.h"
 
 FrameCounter::FrameCounter()
@@ -96,6 +97,7 @@ uint64_t FrameCounter::get() const
 
 void IRAM_ATTR FrameCounter::isrHandler(void* arg)
 {
+    TRACE_SCOPE("pcnt_isr");
     // 'arg' is the 'this' pointer passed in pcnt_isr_handler_add()
     FrameCounter* self = static_cast<FrameCounter*>(arg);
     if (!self) return;
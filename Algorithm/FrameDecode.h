@@ -0,0 +1,79 @@
+#pragma once
+#include "Sampler_settings.h"
+#include "NoiseFloor.h"
+#include "ChannelCalibration.h"
+#include "FixedPoint.h"
+
+// One little endian I2S slot of BYTES_PER_SAMPLE bytes, MSB aligned to Q31 whatever the
+// slot width, so code_to_voltage() and the Q31 pipeline never see the difference.
+static inline int32_t read_slot(const uint8_t* p)
+{
+#if I2S_SLOT_BITS == 32
+    return (int32_t)p[0] | ((int32_t)p[1] << 8) | ((int32_t)p[2] << 16) | ((int32_t)p[3] << 24);
+#elif I2S_SLOT_BITS == 24
+    return ((int32_t)p[0] << 8) | ((int32_t)p[1] << 16) | ((int32_t)p[2] << 24);
+#else
+    return ((int32_t)p[0] << 16) | ((int32_t)p[1] << 24);
+#endif
+}
+
+// Puts frames back in L, R order where the DMA stores them as R, L (see I2S_SWAPPED_16BIT_FRAMES).
+static inline void fix_slot_order(uint8_t* buf, size_t n_frames)
+{
+#ifdef I2S_SWAPPED_16BIT_FRAMES
+    uint16_t* slot = (uint16_t*)buf;
+    for (size_t j = 0; j < n_frames; j++, slot += CHANNELS) { uint16_t r = slot[0]; slot[0] = slot[1]; slot[1] = r; }
+#else
+    (void)buf;
+    (void)n_frames;
+#endif
+}
+
+// Inverse of read_slot(), the low bits of a Q31 code beyond the slot width are dropped.
+static inline void write_slot(uint8_t* p, int32_t code)
+{
+    for (int k = 0; k < BYTES_PER_SAMPLE; k++) { p[k] = (uint8_t)((uint32_t)code >> (8 * (4 - BYTES_PER_SAMPLE + k))); }
+}
+
+static inline float code_to_voltage(int32_t input)
+{
+    const float CODE_FS       = 2147483648.0f;            // 2^31
+    const float VFS_DIFF_RMS  = 2.0f;                     // 2 Vrms differential
+    const float VFS_DIFF_PEAK = VFS_DIFF_RMS * 1.41421356237f;
+    return (float)input / CODE_FS * VFS_DIFF_PEAK;
+}
+
+// Interleaved DMA frames to interleaved volts through the channel correction. noise holds one
+// estimator per channel to update, or nullptr. Used by Sampler::to_voltage() and host/bench_stages.
+static inline void decode_frames(size_t n_frames, const uint8_t* input_buf, float* output, ChannelCorrector& correction, NoiseFloor* noise)
+{
+    // Frames are already interleaved in the DMA data, so this is a straight decode.
+    const uint8_t* p = input_buf;
+    for (size_t j = 0; j < n_frames; j++)
+    {
+        for (int c = 0; c < CHANNELS; c++, p += BYTES_PER_SAMPLE)
+        {
+            float v = code_to_voltage(read_slot(p));
+            if (correction.enabled) { v = correction.process(c, v); }
+            output[j * CHANNELS + c] = v;
+            if (noise) { noise[c].update(v); }
+        }
+    }
+}
+
+// decode_frames into Q31 (FixedSolver.h). Without the channel correction the slots are
+// copied as they are; the correction FIR runs in float.
+static inline void decode_frames_q31(size_t n_frames, const uint8_t* input_buf, q31_t* output, ChannelCorrector& correction, NoiseFloor* noise)
+{
+    const uint8_t* p = input_buf;
+    for (size_t j = 0; j < n_frames; j++)
+    {
+        for (int c = 0; c < CHANNELS; c++, p += BYTES_PER_SAMPLE)
+        {
+            q31_t x = read_slot(p);
+            if (correction.enabled) { x = q31_from_volts(correction.process(c, code_to_voltage(x))); }
+            output[j * CHANNELS + c] = x;
+            if (noise) { noise[c].update(q31_to_volts(x)); }
+        }
+    }
+}
@@ -0,0 +1,3 @@
+#include "HotArena.h"
+
+HotArena hot_arena;
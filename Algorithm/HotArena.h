@@ -0,0 +1,46 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "Sampler_settings.h"
+#include "SignalWindow.h"
+
+#define ARENA_ALIGN 16 // Cache line and DMA friendly, also fine for the float kernels.
+
+// Every buffer on the capture and analysis hot paths, carved from one statically
+// allocated block instead of task stacks and scattered statics. Each region has one owner:
+//
+//   region      owner            used by
+//   raw         capture core     read_frames() target of discard_frames, read_samples, read_interleaved
+//   sync        capture core     sync_indicies() pulse search, left channel plus the code overlap
+//   sync_other  capture core     sync_indicies() right channel, decoded but not inspected
+//   listen      capture core     free-running blocks kept for the frames before an onset
+//   handoff     both, SPSC       captured windows, written by the capture core, read by the analysis core
+//
+// The regions are never in use at the same time within one owner, so they could be
+// overlaid later; for now each gets its own slot.
+struct alignas(ARENA_ALIGN) HotArena {
+    alignas(ARENA_ALIGN) uint8_t raw[FRAMES_PER_READ * BYTES_PER_FRAME];
+    alignas(ARENA_ALIGN) float sync[FRAMES_PER_READ + SYNC_CODE_TOTAL_LEN];
+    alignas(ARENA_ALIGN) float sync_other[FRAMES_PER_READ];
+    alignas(ARENA_ALIGN) float listen[2][CHANNELS * FRAMES_PER_READ];
+    alignas(ARENA_ALIGN) WindowHandoff handoff;
+};
+
+extern HotArena hot_arena;
+
+// Region table for the memory report.
+struct ArenaRegion {
+    const char* name;
+    size_t offset;
+    size_t size;
+};
+
+#define ARENA_REGION(field) { #field, offsetof(HotArena, field), sizeof(HotArena::field) }
+
+static const ArenaRegion ARENA_REGIONS[] = {
+    ARENA_REGION(raw),
+    ARENA_REGION(sync),
+    ARENA_REGION(sync_other),
+    ARENA_REGION(listen),
+    ARENA_REGION(handoff),
+};
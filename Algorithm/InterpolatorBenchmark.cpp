@@ -0,0 +1,108 @@
+#include "InterpolatorBenchmark.h"
+
+#ifdef INTERPOLATOR_BENCHMARK
+
+#include <Arduino.h>
+#include "PeakInterpolator.h"
+#include "SignalAnalyzer.h"
+#include "SyntheticBurst.h"
+
+struct BenchResult {
+    uint64_t cycles = 0;
+    size_t n_peaks = 0;
+    size_t n_failed = 0;
+    double sum_err2 = 0.0; // us^2
+    double max_err = 0.0;  // us
+};
+
+static float bench_samples[BENCH_FRAMES];
+
+// Same first N_PEAKS local maxima for every policy, taken from the rising edge onwards.
+static size_t find_local_peaks(const SyntheticBurst& burst, size_t* peaks)
+{
+    size_t n = 0;
+    size_t start = (size_t)burst.onset + INTERPOLATION_NEIGHBOURS;
+    for (size_t i = start; i + INTERPOLATION_NEIGHBOURS < BENCH_FRAMES && n < N_PEAKS; i++) {
+        float v = bench_samples[i];
+        if (v > 0.2f * burst.amplitude && v > bench_samples[i - 1] && v >= bench_samples[i + 1]) {
+            peaks[n++] = i;
+        }
+    }
+    return n;
+}
+
+template <class Policy>
+static void bench_policy(const SyntheticBurst& burst, const size_t* est_peaks, size_t n_peaks, BenchResult& res)
+{
+    PeakInterpolator interpolator(bench_samples);
+    float peaks[N_PEAKS], time[N_PEAKS];
+
+    uint32_t c0 = ESP.getCycleCount();
+    bool ok = interpolator.interpolate_peaks<Policy>(BENCH_FRAMES, n_peaks, est_peaks, peaks, time);
+    uint32_t c1 = ESP.getCycleCount();
+
+    if (!ok) { res.n_failed++; return; }
+    res.cycles += (uint32_t)(c1 - c0);
+
+    for (size_t j = 0; j < n_peaks; j++) {
+        double truth = burst.true_peak((double)est_peaks[j]) * SAMPLE_T_US;
+        double err = fabs((double)time[j] - truth);
+        res.sum_err2 += err * err;
+        if (err > res.max_err) { res.max_err = err; }
+        res.n_peaks++;
+    }
+}
+
+static void print_result(const char* name, float snr_db, const BenchResult& res)
+{
+    double n = res.n_peaks ? (double)res.n_peaks : 1.0;
+    Serial.print(name); Serial.print(",");
+    Serial.print(snr_db, 1); Serial.print(",");
+    Serial.print((float)((double)res.cycles / n), 1); Serial.print(",");
+    Serial.print((float)(sqrt(res.sum_err2 / n) * 1000.0), 3); Serial.print(",");
+    Serial.print((float)(res.max_err * 1000.0), 3); Serial.print(",");
+    Serial.println((unsigned long)res.n_failed);
+}
+
+template <class Policy>
+static void bench_snr(float snr_db)
+{
+    BenchResult res;
+    uint32_t seed = 0x12345678u; // Same bursts for every policy.
+
+    for (int b = 0; b < BENCH_BURSTS; b++) {
+        SyntheticBurst burst;
+        burst.onset = 200.0f + 100.0f * SyntheticBurst::uniform(seed);
+        burst.phase = 2.0f * _PI * SyntheticBurst::uniform(seed);
+        burst.noise_rms = isinf(snr_db) ? 0.0f : burst.amplitude / sqrtf(2.0f) * powf(10.0f, -snr_db / 20.0f);
+        burst.render(bench_samples, BENCH_FRAMES, seed);
+
+        size_t est_peaks[N_PEAKS];
+        size_t n_peaks = find_local_peaks(burst, est_peaks);
+        if (n_peaks == 0) { continue; }
+
+        bench_policy<Policy>(burst, est_peaks, n_peaks, res);
+    }
+    print_result(Policy::NAME, snr_db, res);
+}
+
+template <class Policy>
+static void bench_all_snr()
+{
+    bench_snr<Policy>(INFINITY);
+    bench_snr<Policy>(40.0f);
+    bench_snr<Policy>(20.0f);
+}
+
+void run_interpolator_benchmark()
+{
+    Serial.println("policy,snr_db,cycles_per_peak,rms_err_ns,max_err_ns,failed");
+    bench_all_snr<ParabolicPeak>();
+    bench_all_snr<GaussianPeak>();
+    bench_all_snr<CubicSplinePeak>();
+    bench_all_snr<SincTablePeak>();
+    bench_all_snr<SincExactPeak>();
+    Serial.flush();
+}
+
+#endif
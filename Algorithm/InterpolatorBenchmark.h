@@ -0,0 +1,10 @@
+#pragma once
+
+//#define INTERPOLATOR_BENCHMARK // Run the interpolator benchmark from setup() instead of measuring.
+
+#define BENCH_BURSTS 200
+#define BENCH_FRAMES 1024
+
+#ifdef INTERPOLATOR_BENCHMARK
+void run_interpolator_benchmark();
+#endif
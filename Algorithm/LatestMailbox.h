@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+// Wait-free latest-value mailbox for one writer and one reader (triple buffer).
+// The writer fills its private slot and swaps it with the shared one; the reader swaps
+// the shared slot for its private one when something new is there. Neither side ever
+// waits, and the reader keeps a pointer to its slot until its next read().
+template <class T>
+class LatestMailbox {
+    public:
+    // Writer side.
+    T& write_slot() { return slots[write_i]; }
+
+    void publish()
+    {
+        uint8_t prev = shared.exchange(write_i | FRESH, std::memory_order_acq_rel);
+        write_i = prev & INDEX_MASK;
+    }
+
+    // Reader side. Latest published value, nullptr before the first publish.
+    const T* read()
+    {
+        if (shared.load(std::memory_order_relaxed) & FRESH)
+        {
+            uint8_t prev = shared.exchange(read_i, std::memory_order_acq_rel);
+            read_i = prev & INDEX_MASK;
+            has_value = true;
+        }
+        return has_value ? &slots[read_i] : nullptr;
+    }
+
+    // True when a value was published since the last read().
+    bool fresh() const { return shared.load(std::memory_order_relaxed) & FRESH; }
+
+    private:
+    static constexpr uint8_t FRESH = 0x4;
+    static constexpr uint8_t INDEX_MASK = 0x3;
+
+    T slots[3];
+    std::atomic<uint8_t> shared{1};
+    uint8_t write_i = 0; // writer only
+    uint8_t read_i = 2;  // reader only
+    bool has_value = false;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+
+// Every LOG() message, shared by the firmware and host/log_decode. Records carry the index
+// into this table and the raw argument words, never the text.
+//
+// Conversions: %d %i %u %x %X %c take one 32 bit word, %f one float, %lld %llu %llx two
+// words (64 bit); width and precision are allowed. Append new messages at the end so older captures still decode.
+#define LOG_FORMATS(X) \
+    X(LOG_DROPPED,            "log: %u records dropped") \
+    X(LOG_WINDOW,             "###################################\nSignal offset: %u samples") \
+    X(LOG_RESULT,             "angle: %.4f degrees\ndistance: %.6f cm") \
+    X(LOG_FAILED_ANALYZER,    "Failed: analyzer") \
+    X(LOG_FAILED_INTERP_L,    "Failed: interpolator left") \
+    X(LOG_FAILED_INTERP_R,    "Failed: interpolator right") \
+    X(LOG_START_NOT_FOUND,    "Start not found!") \
+    X(LOG_START_NOT_FOUND_R,  "Start not found right!") \
+    X(LOG_PEAKS_NOT_FOUND,    "Not all peaks found!") \
+    X(LOG_FETCH_STUCK,        "STUCK") \
+    X(LOG_LRCLK_FREQ,         "LRCLK freq: %llu") \
+    X(LOG_SYNC_SCORE,         "Best sync score: %d") \
+    X(LOG_SYNC_FOUND,         "[Sampler::sync_indicies] readIndex diff: %d, base: %.6f\nold read index: %llu, sync index: %llu") \
+    X(LOG_SYNC_NOT_FOUND,     "[Sampler::sync_indicies] sync pulse NOT found. read frames: %u, base: %.6f\nold read index: %llu, sync index: %llu") \
+    X(LOG_SAMPLE_RATE,        "[Sampler::set_sample_rate] %u Hz, resync: %d")
+
+#define LOG_X_ID(id, format) id,
+#define LOG_X_FORMAT(id, format) format,
+
+enum LogId : uint16_t { LOG_FORMATS(LOG_X_ID) LOG_COUNT };
+
+static constexpr const char* LOG_FORMAT_STRINGS[LOG_COUNT] = { LOG_FORMATS(LOG_X_FORMAT) };
+
+// Argument words a format expects.
+static constexpr uint8_t log_format_words(const char* f)
+{
+    uint8_t n = 0;
+    while (*f)
+    {
+        if (*f++ != '%') { continue; }
+        if (*f == '%') { f++; continue; }
+        while (*f == '-' || *f == '0' || *f == '.' || (*f >= '1' && *f <= '9')) { f++; }
+        if (f[0] == 'l' && f[1] == 'l') { n += 2; f += 2; } else { n += 1; }
+        if (*f) { f++; }
+    }
+    return n;
+}
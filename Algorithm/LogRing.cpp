@@ -0,0 +1,55 @@
+#include "LogRing.h"
+
+LogRing log_ring;
+
+size_t LogRing::pop_frame(uint8_t* out)
+{
+    LogRecord& r = slots[head & (LOG_RING_LEN - 1)];
+    if ((int32_t)(r.seq.load(std::memory_order_acquire) - (head + 1)) < 0) { return 0; }
+
+    uint8_t* p = out;
+    *p++ = LOG_FRAME_MAGIC;
+    *p++ = (uint8_t)r.id;
+    *p++ = (uint8_t)(r.id >> 8);
+    *p++ = r.n_words;
+    for (int s = 0; s < 32; s += 8) { *p++ = (uint8_t)(r.time_us >> s); }
+    for (uint8_t i = 0; i < r.n_words; i++)
+    {
+        for (int s = 0; s < 32; s += 8) { *p++ = (uint8_t)(r.words[i] >> s); }
+    }
+    uint8_t sum = 0;
+    for (uint8_t* q = out + 1; q < p; q++) { sum += *q; }
+    *p++ = sum;
+
+    r.seq.store(head + LOG_RING_LEN, std::memory_order_release);
+    head++;
+    return (size_t)(p - out);
+}
+
+#ifdef ASYNC_LOG
+
+// Sends every queued record, then reports drops. Serial.write() of one frame is not
+// interleaved with other Serial output, so plain text prints stay readable.
+static void log_drain_task(void*)
+{
+    uint8_t frame[LOG_FRAME_MAX];
+    for (;;)
+    {
+        size_t n;
+        while ((n = log_ring.pop_frame(frame)) > 0) { Serial.write(frame, n); }
+
+        uint32_t dropped = log_ring.dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped) { LOG(LOG_DROPPED, dropped); }
+
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_MS));
+    }
+}
+
+TaskHandle_t log_begin(UBaseType_t priority, BaseType_t core)
+{
+    TaskHandle_t handle = NULL;
+    xTaskCreatePinnedToCore(log_drain_task, "Log Task", LOG_TASK_STACK, NULL, priority, &handle, core);
+    return handle;
+}
+
+#endif
@@ -0,0 +1,136 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <type_traits>
+#include "LogFormats.h"
+
+// Binary logging for the capture and analysis paths. LOG(id, args...) stores the message id
+// and its raw argument words in a lock free ring; a low priority task drains the ring to
+// the UART as framed records, and host/log_decode turns them back into text. Writing a
+// record costs a few dozen cycles and never blocks, so the DMA ring cannot overrun while
+// the UART is busy. Safe from any task or ISR on either core.
+//
+// Off the ESP32 (host tools) LOG() prints the text synchronously through Serial.printf().
+#ifdef ESP_PLATFORM
+#define ASYNC_LOG // Comment out for plain text Serial output, without the decoder.
+#endif
+
+#define LOG_RING_LEN 64      // records, power of two
+#define LOG_MAX_WORDS 6      // argument words per record
+#define LOG_DRAIN_MS 20      // drain task period
+#define LOG_TASK_STACK 3072  // bytes
+#define LOG_FRAME_MAGIC 0xA5 // not ASCII, so the decoder can pass plain Serial text through
+
+// Wire format of one record, little endian:
+//   LOG_FRAME_MAGIC, id (u16), n_words (u8), time_us (u32), words (u32 x n_words), sum (u8)
+// sum is the byte sum of everything between the magic and itself.
+#define LOG_FRAME_HEADER 8
+#define LOG_FRAME_MAX (LOG_FRAME_HEADER + 4 * LOG_MAX_WORDS + 1)
+
+static_assert((LOG_RING_LEN & (LOG_RING_LEN - 1)) == 0, "LOG_RING_LEN must be a power of two");
+
+struct LogRecord {
+    std::atomic<uint32_t> seq;
+    uint32_t time_us;
+    uint16_t id;
+    uint8_t n_words;
+    uint32_t words[LOG_MAX_WORDS];
+};
+
+// Bounded multi-producer single-consumer ring (sequence number per slot). A producer that
+// finds the ring full drops its record and counts it; the drain task reports the count.
+class LogRing {
+public:
+    LogRing()
+    {
+        for (uint32_t i = 0; i < LOG_RING_LEN; i++) { slots[i].seq.store(i, std::memory_order_relaxed); }
+    }
+
+    bool push(uint16_t id, const uint32_t* words, uint8_t n_words)
+    {
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            LogRecord& r = slots[pos & (LOG_RING_LEN - 1)];
+            int32_t diff = (int32_t)(r.seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+            }
+            else if (diff < 0) { dropped.fetch_add(1, std::memory_order_relaxed); return false; }
+            else { pos = tail.load(std::memory_order_relaxed); }
+        }
+
+        LogRecord& r = slots[pos & (LOG_RING_LEN - 1)];
+        r.time_us = (uint32_t)micros();
+        r.id = id;
+        r.n_words = n_words;
+        for (uint8_t i = 0; i < n_words; i++) { r.words[i] = words[i]; }
+        r.seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: frames the oldest record into out, returns its length or 0 when empty.
+    size_t pop_frame(uint8_t* out);
+
+    std::atomic<uint32_t> dropped{0};
+
+private:
+    LogRecord slots[LOG_RING_LEN];
+    std::atomic<uint32_t> tail{0};
+    uint32_t head = 0;
+};
+
+extern LogRing log_ring;
+
+#ifdef ASYNC_LOG
+TaskHandle_t log_begin(UBaseType_t priority, BaseType_t core); // starts the drain task
+#endif
+
+// Argument words: 64 bit integers take two, everything else one (floats as their bits).
+template <class T>
+static constexpr uint8_t log_arg_words()
+{
+    return (std::is_integral<T>::value && sizeof(T) == 8) ? 2 : 1;
+}
+
+template <class... A>
+static constexpr uint8_t log_args_words() { return (uint8_t)(0 + ... + log_arg_words<A>()); }
+
+template <class T>
+static inline void log_pack(uint32_t*& w, T v)
+{
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        float f = (float)v;
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        *w++ = bits;
+    }
+    else if constexpr (sizeof(T) == 8)
+    {
+        *w++ = (uint32_t)((uint64_t)v);
+        *w++ = (uint32_t)((uint64_t)v >> 32);
+    }
+    else { *w++ = (uint32_t)v; }
+}
+
+template <LogId ID, class... A>
+static inline void log_write(A... args)
+{
+    static_assert(log_format_words(LOG_FORMAT_STRINGS[ID]) == log_args_words<A...>(), "LOG() arguments do not match the format in LogFormats.h");
+    static_assert(log_args_words<A...>() <= LOG_MAX_WORDS, "Too many LOG() arguments");
+    #ifdef ASYNC_LOG
+    uint32_t words[LOG_MAX_WORDS];
+    uint32_t* w = words;
+    (log_pack(w, args), ...);
+    log_ring.push(ID, words, log_args_words<A...>());
+    #else
+    Serial.printf(LOG_FORMAT_STRINGS[ID], args...);
+    Serial.println();
+    #endif
+}
+
+// LOG(LOG_RESULT, angle, distance). Pass size_t and other platform sized integers as
+// uint32_t or uint64_t so the word count is the same on the host.
+#define LOG(id, ...) log_write<id>(__VA_ARGS__)
@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+#define MEASUREMENT_QUEUE_LEN 16
+
+// Time spent in each stage of Solver::solve, in CPU cycles (ESP.getCycleCount()).
+struct StageTimings {
+    uint32_t analyze = 0;
+    uint32_t normalize = 0;
+    uint32_t interpolate = 0;
+    uint32_t correlate = 0;
+    uint32_t line_fit = 0;
+};
+
+// One result of Algorithm::process_window, published to LatestMailbox and SpscQueue.
+struct Measurement {
+    uint32_t seq = 0;            // increments per published measurement
+    float angle = 0.0f;          // degrees
+    float distance = 0.0f;       // cm, NaN when the window had no emission time
+    uint64_t trigger_index = 0;  // frame index of the trigger / emission
+    float confidence = 0.0f;     // 0..1, normalized correlation of the aligned peak trains
+    StageTimings timing;
+};
@@ -0,0 +1,41 @@
+#include "MemoryReport.h"
+#include "HotArena.h"
+
+struct TaskStack {
+    const char* name;
+    TaskHandle_t handle;
+    uint32_t stack_bytes;
+};
+
+static TaskStack tasks[MEMORY_REPORT_MAX_TASKS];
+static size_t n_tasks = 0;
+
+void memory_report_add_task(const char* name, TaskHandle_t handle, uint32_t stack_bytes)
+{
+    if (n_tasks >= MEMORY_REPORT_MAX_TASKS || !handle) { return; }
+    tasks[n_tasks++] = { name, handle, stack_bytes };
+}
+
+void print_memory_report()
+{
+    Serial.print("Arena: "); Serial.print((unsigned long)sizeof(HotArena)); Serial.print(" bytes at 0x");
+    Serial.println((unsigned long)(uintptr_t)&hot_arena, HEX);
+    for (const ArenaRegion& r : ARENA_REGIONS)
+    {
+        Serial.print("  "); Serial.print(r.name);
+        Serial.print(" +"); Serial.print((unsigned long)r.offset);
+        Serial.print(" "); Serial.print((unsigned long)r.size); Serial.println(" bytes");
+    }
+
+    for (size_t i = 0; i < n_tasks; i++)
+    {
+        uint32_t free_min = uxTaskGetStackHighWaterMark(tasks[i].handle);
+        Serial.print("Stack "); Serial.print(tasks[i].name);
+        Serial.print(": "); Serial.print((unsigned long)(tasks[i].stack_bytes - free_min));
+        Serial.print(" of "); Serial.print((unsigned long)tasks[i].stack_bytes);
+        Serial.print(" bytes used at peak, "); Serial.print((unsigned long)free_min); Serial.println(" never touched");
+    }
+
+    Serial.print("Heap: "); Serial.print((unsigned long)ESP.getFreeHeap());
+    Serial.print(" bytes free, "); Serial.print((unsigned long)ESP.getMinFreeHeap()); Serial.println(" at minimum");
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <Arduino.h>
+
+#define MEMORY_REPORT_MAX_TASKS 4
+
+// Arena layout, task stack high-water marks and heap, printed on demand.
+// On the ESP32 uxTaskGetStackHighWaterMark() counts bytes: the least free stack ever seen.
+void memory_report_add_task(const char* name, TaskHandle_t handle, uint32_t stack_bytes);
+void print_memory_report();
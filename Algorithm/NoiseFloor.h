@@ -0,0 +1,24 @@
+#pragma once
+#include <math.h>
+
+#define NOISE_FLOOR_ALPHA (1.0f / 4096.0f) // EWMA weight per sample at SAMPLE_RATE_HZ, ~21 ms time constant
+
+// Exponentially weighted mean and variance of the squared samples of one channel.
+// O(1) per sample, fed from the decode loops so no samples are converted twice.
+struct NoiseFloor {
+    float mean = 0.0f; // V^2
+    float var = 0.0f;  // V^4
+    bool primed = false;
+    float alpha = NOISE_FLOOR_ALPHA; // SampleClock::per_frame(NOISE_FLOOR_ALPHA) at other rates
+
+    inline void update(float v)
+    {
+        float x = v * v;
+        if (!primed) { mean = x; primed = true; return; }
+        float d = x - mean;
+        mean += alpha * d;
+        var = (1.0f - alpha) * (var + alpha * d * d);
+    }
+
+    float stddev() const { return sqrtf(var); }
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "Sampler_settings.h"
+#include "SignalAnalyzer.h"
+
+// Streaming version of the energy onset test in SignalAnalyzer::detect_start.
+// Keeps the last ENERGY_WINDOW squared samples of every channel and a running sum,
+// so each frame costs O(1).
+class OnsetDetector {
+    public:
+    void reset()
+    {
+        for (int c = 0; c < CHANNELS; c++) {
+            energy[c] = 0.0f;
+            for (int k = 0; k < ENERGY_WINDOW; k++) { squares[c][k] = 0.0f; }
+        }
+        pos = 0;
+        filled = 0;
+    }
+
+    // Feeds one interleaved frame. True when a channel's window energy reaches its threshold,
+    // clamped as SignalAnalyzer::fixed_threshold() does.
+    inline bool step(const float* frame, const float* thresholds)
+    {
+        bool hit = false;
+        for (int c = 0; c < CHANNELS; c++) {
+            float v = frame[c];
+            float vv = v * v;
+            energy[c] += vv - squares[c][pos];
+            squares[c][pos] = vv;
+            if (filled >= ENERGY_WINDOW - 1 && energy[c] >= thresholds[c]) { hit = true; }
+        }
+        pos = (pos + 1 == ENERGY_WINDOW) ? 0 : pos + 1;
+        if (filled < ENERGY_WINDOW) { filled++; }
+        return hit;
+    }
+
+    private:
+    float squares[CHANNELS][ENERGY_WINDOW] = {};
+    float energy[CHANNELS] = {};
+    int pos = 0;
+    int filled = 0;
+};
+
+// Emission times of the transmitter, which bursts every period_frames frames.
+// The phase is anchored to one known emission, e.g. a radio trigger or a burst at a known distance.
+struct TransmitSchedule {
+    uint64_t epoch = 0;     // frame index of a known emission
+    uint32_t period_frames = 0;
+    bool valid = false;
+
+    void anchor(uint64_t emission_index) { epoch = emission_index; valid = period_frames > 0; }
+
+    // Latest emission at or before index.
+    uint64_t emission_before(uint64_t index) const
+    {
+        if (index < epoch) { return epoch - ((epoch - index + period_frames - 1) / period_frames) * period_frames; }
+        return index - (index - epoch) % period_frames;
+    }
+};
@@ -1,31 +1,75 @@
 #include "math.h"
+#include "PeakPolicies.h"
+#include "SampleRate.h"
 
+// DC offset, abs max and energy (DC removed) of the region around the peaks.
+struct RegionStats {
+    size_t start = 0, end = 0;
+    float dc = 0.0f;
+    float abs_max = 0.0f;
+    float energy = 0.0f;
+    float gain = 1.0f; // 1 / abs_max
+};
+
+// Frames around the estimated peaks that the interpolators may read.
+static inline void peak_region(size_t n_frames, size_t n_peaks, const size_t* est_peaks, RegionStats& stats)
+{
+    int start_index = (int)est_peaks[0] - INTERPOLATION_NEIGHBOURS - 2;
+    if (start_index < 0) { start_index = 0; }
 
-#define INTERPOLATION_NEIGHBOURS 5
-#define _PI 3.14159265358979323846f
-#define _TWO_PI 2.0f * _PI
-#define _HALF_PI (_PI * 0.5f)
+    int end_index = (int)est_peaks[n_peaks-1] + INTERPOLATION_NEIGHBOURS + 2;
+    if (end_index > (int)n_frames) { end_index = (int)n_frames; }
 
-#ifndef SAMPLE_T_US
-#define SAMPLE_T_US 1000.0f / 192.0f
-#endif
+    stats.start = (size_t)start_index;
+    stats.end = (size_t)end_index;
+}
 
-class PeakInterpolator {
+// Samples is const float* or a view that indexes the same way (WindowSamples, see WindowStorage.h).
+template <class Samples>
+class BasicPeakInterpolator {
     public:
-    PeakInterpolator(float* sample_buffer) : samples(sample_buffer) {}
+    // stride: distance between two samples of this channel, CHANNELS for interleaved frames.
+    BasicPeakInterpolator(Samples sample_buffer, size_t stride = 1) : samples(sample_buffer), stride(stride) {}
+
+    void set_buffer(Samples sample_buffer) { samples = sample_buffer; }
+
+    // Normalization applied to the samples when they are gathered for interpolation.
+    void set_scale(const RegionStats& stats) { offset = stats.dc; gain = stats.gain; }
+
+    // us per frame of the window.
+    void set_frame_us(float us) { frame_us = us; }
+
+    // Refine every estimated peak with Policy (see PeakPolicies.h). Time is in us.
+    template <class Policy>
+    bool interpolate_peaks(size_t n_samples, size_t n_peaks, const size_t* est_peaks, float* peaks, float* time)
+    {
+        float x[2 * Policy::REACH + 1];
+        for (size_t j = 0; j < n_peaks; j++)
+        {
+            size_t index = est_peaks[j];
+            if (index < (size_t)Policy::REACH || index + Policy::REACH >= n_samples) { return false; }
+
+            for (int m = -Policy::REACH; m <= Policy::REACH; m++) {
+                x[m + Policy::REACH] = (samples[(index + m) * stride] - offset) * gain;
+            }
+
+            float delta;
+            if (!Policy::refine(x + Policy::REACH, delta, peaks[j])) { return false; }
+            time[j] = ((float)index + delta) * frame_us;
+        }
+        return true;
+    }
+
     bool interpolate_peaks(size_t n_samples, size_t n_peaks, const size_t* est_peaks, float* peaks, float* time);
+    bool interpolate_peaks_table(size_t n_samples, size_t n_peaks, const size_t* est_peaks, float* peaks, float* time);
     bool interpolate_peaks_parabolic(size_t n_samples, size_t n_peaks, const size_t* est_peaks, float* peaks, float* time);
 
     private:
-    void normalize(size_t n_samples, size_t start_index, size_t end_index);
-    bool interpolate_peak(size_t n_samples, size_t index, float& t, float& val);
-    bool interpolate_peak_parabolic(size_t n_samples, size_t index, float& t, float& val);
-    float windowed_sinc_pi(size_t k, float delta);
-    float windowed_sinc_pi_der(size_t k, float delta);
-    float fast_sinc_pi_der(float u);
-    float fast_sinc_pi(float u);
-    float fast_sin(float x);
-    float fast_cos(float x);
-
-    float* samples;
+    Samples samples;
+    size_t stride;
+    float offset = 0.0f;
+    float gain = 1.0f;
+    float frame_us = SAMPLE_T_US;
 };
+
+typedef BasicPeakInterpolator<const float*> PeakInterpolator;
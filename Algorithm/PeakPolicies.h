@@ -0,0 +1,281 @@
+#pragma once
+#include "math.h"
+#include "SincTable.h"
+#include "FixedPoint.h"
+
+#define INTERPOLATION_NEIGHBOURS 5
+#define _PI 3.14159265358979323846f
+#define _TWO_PI 2.0f * _PI
+#define _HALF_PI (_PI * 0.5f)
+
+static_assert(SINC_TABLE_HALF_TAPS == INTERPOLATION_NEIGHBOURS, "Sinc table must span the interpolation neighbours");
+
+// Peak refinement policies for PeakInterpolator::interpolate_peaks<Policy>().
+//
+// Every policy provides:
+//   REACH   - samples needed on each side of the estimated peak.
+//   NAME    - label used by the benchmark.
+//   refine  - x points at the estimated peak sample, x[-REACH .. REACH] is valid.
+//             Returns the offset of the true peak in samples (delta) and its value.
+
+struct ParabolicPeak {
+    static constexpr int REACH = 1;
+    static constexpr const char* NAME = "parabolic";
+
+    static inline bool refine(const float* x, float& delta, float& val)
+    {
+        // quadratic through x=-1,0,+1:
+        // a = 0.5*(ym1 + yp1) - y0
+        // b = 0.5*(yp1 - ym1)
+        // c = y0
+        float a = 0.5f * (x[-1] + x[1]) - x[0];
+        float b = 0.5f * (x[1] - x[-1]);
+        float c = x[0];
+
+        // vertex x-coordinate (offset from k): delta = -b / (2a)
+        float denom = 2.0f * a;
+        if (fabsf(denom) < 1e-9f) {
+            delta = 0.0f;
+        } else {
+            delta = -b / denom;
+            // clamp: we don't trust crazy moves
+            if (delta >  0.5f) delta =  0.5f;
+            if (delta < -0.5f) delta = -0.5f;
+        }
+
+        val = (a * delta + b) * delta + c;
+        return true;
+    }
+};
+
+// Parabola through the log of the samples, exact for a Gaussian shaped peak.
+// Falls back to the plain parabola when a sample is not positive.
+struct GaussianPeak {
+    static constexpr int REACH = 1;
+    static constexpr const char* NAME = "gaussian";
+
+    static inline bool refine(const float* x, float& delta, float& val)
+    {
+        if (x[-1] <= 0.0f || x[0] <= 0.0f || x[1] <= 0.0f) {
+            return ParabolicPeak::refine(x, delta, val);
+        }
+
+        float lm1 = logf(x[-1]);
+        float l0  = logf(x[0]);
+        float lp1 = logf(x[1]);
+
+        float denom = lm1 - 2.0f * l0 + lp1;
+        if (fabsf(denom) < 1e-9f) {
+            delta = 0.0f;
+        } else {
+            delta = 0.5f * (lm1 - lp1) / denom;
+            if (delta >  0.5f) delta =  0.5f;
+            if (delta < -0.5f) delta = -0.5f;
+        }
+
+        val = expf(l0 - 0.25f * (lm1 - lp1) * delta);
+        return true;
+    }
+};
+
+// Natural cubic spline through x[-2..2]. The maximum is searched on the
+// segment towards the larger neighbour.
+struct CubicSplinePeak {
+    static constexpr int REACH = 2;
+    static constexpr const char* NAME = "cubic_spline";
+
+    static inline bool refine(const float* x, float& delta, float& val)
+    {
+        // Second derivatives at -1, 0, 1 (zero at the ends).
+        float dm1 = 6.0f * (x[-2] - 2.0f * x[-1] + x[0]);
+        float d0  = 6.0f * (x[-1] - 2.0f * x[0]  + x[1]);
+        float dp1 = 6.0f * (x[0]  - 2.0f * x[1]  + x[2]);
+
+        float M[3];
+        M[1] = (d0 - 0.25f * (dm1 + dp1)) / 3.5f;
+        M[0] = 0.25f * (dm1 - M[1]);
+        M[2] = 0.25f * (dp1 - M[1]);
+
+        // Segment [i, i+1], i = 0 or -1.
+        int i = (x[1] > x[-1]) ? 0 : -1;
+        float y0 = x[i], y1 = x[i + 1];
+        float m0 = M[i + 1], m1 = M[i + 2];
+
+        // S'(s) = A s^2 + B s + C, s in [0, 1]
+        float A = 0.5f * (m1 - m0);
+        float B = m0;
+        float C = (y1 - y0) - m0 / 3.0f - m1 / 6.0f;
+
+        float s = -1.0f;
+        if (fabsf(A) < 1e-9f) {
+            if (fabsf(B) > 1e-9f) { s = -C / B; }
+        } else {
+            float disc = B * B - 4.0f * A * C;
+            if (disc >= 0.0f) {
+                float r = sqrtf(disc);
+                float s1 = (-B + r) / (2.0f * A);
+                float s2 = (-B - r) / (2.0f * A);
+                // Maximum where S'' = B + 2 A s < 0
+                s = (B + 2.0f * A * s1 < 0.0f) ? s1 : s2;
+            }
+        }
+        if (s < 0.0f || s > 1.0f) {
+            return ParabolicPeak::refine(x, delta, val);
+        }
+
+        delta = (float)i + s;
+        if (delta >  0.5f) { delta =  0.5f; s = 0.5f - (float)i; }
+        if (delta < -0.5f) { delta = -0.5f; s = -0.5f - (float)i; }
+
+        float r = 1.0f - s;
+        val = r * y0 + s * y1 + ((r * r * r - r) * m0 + (s * s * s - s) * m1) / 6.0f;
+        return true;
+    }
+};
+
+// Band-limited reconstruction over INTERPOLATION_NEIGHBOURS samples on each side,
+// root of the derivative found with a secant search. Kernel evaluation is supplied by Kernel.
+template <class Kernel>
+struct SincPeak {
+    static constexpr int REACH = INTERPOLATION_NEIGHBOURS;
+    static constexpr const char* NAME = Kernel::NAME;
+
+    static inline bool refine(const float* x, float& delta, float& val)
+    {
+        float delta0 = -0.01f;
+        float delta1 = 0.01f; // Smaller maybe?
+
+        float g0 = Kernel::sinc_der(x, delta0);
+        float g1 = Kernel::sinc_der(x, delta1);
+
+        for (int iter = 0; iter < 10; ++iter) {
+            float denom = (g1 - g0);
+            if (fabsf(denom) < 1e-6f || fabsf(g1) < 1e-6f) { break; }
+
+            float delta2 = delta1 - g1 * (delta1 - delta0) / denom;
+
+            if (delta2 > 0.5f) { delta2 =  0.5f; }
+            if (delta2 < -0.5f) { delta2 = -0.5f; }
+
+            delta0 = delta1;
+            g0 = g1;
+            delta1 = delta2;
+            g1 = Kernel::sinc_der(x, delta1);
+        }
+
+        delta = delta1;
+        val = Kernel::sinc(x, delta);
+        return true;
+    }
+};
+
+// Exact kernel, 11 sinf/cosf calls per evaluation. Reference for the table.
+struct ExactSincKernel {
+    static constexpr const char* NAME = "sinc_exact";
+
+    static inline float sinc(const float* x, float delta)
+    {
+        float sum = 0.0f;
+        for (int m = -INTERPOLATION_NEIGHBOURS; m <= INTERPOLATION_NEIGHBOURS; ++m) {
+            sum += x[m] * sinc_pi(delta - (float)m);
+        }
+        return sum;
+    }
+
+    static inline float sinc_der(const float* x, float delta)
+    {
+        float sum = 0.0f;
+        for (int m = -INTERPOLATION_NEIGHBOURS; m <= INTERPOLATION_NEIGHBOURS; ++m) {
+            sum += x[m] * sinc_pi_der(delta - (float)m);
+        }
+        return sum;
+    }
+
+    static inline float sinc_pi(float u)
+    {
+        if (fabsf(u) < 1e-6f) { return 1.0f; }
+        float theta = _PI * u;
+        return sinf(theta) / theta;
+    }
+
+    static inline float sinc_pi_der(float u)
+    {
+        if (fabsf(u) < 1e-6f) return 0.0f;
+        float theta = _PI * u;
+        return (theta * cosf(theta) - sinf(theta)) / (_PI * u * u);
+    }
+};
+
+// Polyphase kernel from SincTable.h, two short dot products per evaluation.
+struct TableSincKernel {
+    static constexpr const char* NAME = "sinc_table";
+
+    static inline float sinc(const float* x, float delta) { return sinc_table_dot(SINC_TABLE.sinc, x, delta); }
+    static inline float sinc_der(const float* x, float delta) { return sinc_table_dot(SINC_TABLE.sinc_der, x, delta); }
+};
+
+typedef SincPeak<ExactSincKernel> SincExactPeak;
+typedef SincPeak<TableSincKernel> SincTablePeak;
+
+// Integer policies for FixedPeakInterpolator (FixedSolver.h). x holds the normalized
+// samples in Q15, delta and val are returned in Q15.
+
+struct ParabolicPeakQ15 {
+    static constexpr int REACH = 1;
+    static constexpr const char* NAME = "parabolic_q15";
+
+    static inline bool refine(const int32_t* x, int32_t& delta, int32_t& val)
+    {
+        // 2a and 2b of ParabolicPeak, so nothing is halved before the division.
+        int32_t a2 = x[-1] + x[1] - 2 * x[0];
+        int32_t b2 = x[1] - x[-1];
+
+        if (a2 == 0) {
+            delta = 0;
+        } else {
+            int64_t d = -((int64_t)b2 * Q15_ONE) / (2 * (int64_t)a2);
+            if (d >  Q15_ONE / 2) d =  Q15_ONE / 2;
+            if (d < -Q15_ONE / 2) d = -Q15_ONE / 2;
+            delta = (int32_t)d;
+        }
+
+        // (a delta + b) delta + c
+        int64_t t = (((int64_t)a2 * delta) >> 15) + b2;
+        val = x[0] + (int32_t)((t * delta) >> 16);
+        return true;
+    }
+};
+
+// SincPeak on SINC_TABLE_Q: the same secant search with Q15 offsets.
+struct SincTablePeakQ15 {
+    static constexpr int REACH = INTERPOLATION_NEIGHBOURS;
+    static constexpr const char* NAME = "sinc_table_q15";
+
+    static inline bool refine(const int32_t* x, int32_t& delta, int32_t& val)
+    {
+        int32_t delta0 = -(Q15_ONE / 100);
+        int32_t delta1 = Q15_ONE / 100;
+
+        int32_t g0 = sinc_table_dot_q15(SINC_TABLE_Q.sinc_der, x, delta0);
+        int32_t g1 = sinc_table_dot_q15(SINC_TABLE_Q.sinc_der, x, delta1);
+
+        for (int iter = 0; iter < 10; ++iter) {
+            int32_t denom = g1 - g0;
+            if (denom == 0 || g1 == 0) { break; } // the 1e-6 of SincPeak is below one Q15 step
+
+            int64_t delta2 = delta1 - ((int64_t)g1 * (delta1 - delta0)) / denom;
+
+            if (delta2 >  Q15_ONE / 2) { delta2 =  Q15_ONE / 2; }
+            if (delta2 < -Q15_ONE / 2) { delta2 = -Q15_ONE / 2; }
+
+            delta0 = delta1;
+            g0 = g1;
+            delta1 = (int32_t)delta2;
+            g1 = sinc_table_dot_q15(SINC_TABLE_Q.sinc_der, x, delta1);
+        }
+
+        delta = delta1;
+        val = sinc_table_dot_q15(SINC_TABLE_Q.sinc, x, delta);
+        return true;
+    }
+};
@@ -0,0 +1,72 @@
+#include "Profiler.h"
+
+uint32_t CycleHistogram::percentile(float p) const
+{
+    if (count == 0) { return 0; }
+    uint32_t rank = (uint32_t)(p * (float)(count - 1)) + 1;
+    uint32_t seen = 0;
+    for (int b = 0; b < PROFILE_BUCKETS; b++)
+    {
+        seen += buckets[b];
+        if (seen >= rank) { return (b == 31) ? UINT32_MAX : (2u << b) - 1; }
+    }
+    return max;
+}
+
+static const char* const STAGE_NAMES[PROF_STAGES] = {
+    "calculate", "capture_window", "process_window", "fetch", "handle", "sync_indicies",
+    "solve", "analyze", "normalize", "interpolate", "correlate", "line_fit",
+};
+
+const char* profile_stage_name(ProfileStage stage) { return STAGE_NAMES[stage]; }
+
+#ifdef PROFILING
+
+static CycleHistogram histograms[PROF_STAGES];
+
+void ProfileScope::profile_record(ProfileStage stage, uint32_t cycles)
+{
+    histograms[stage].add(cycles);
+}
+
+const CycleHistogram& profile_histogram(ProfileStage stage) { return histograms[stage]; }
+
+// Racy against probes running on the other core, a sample may survive the reset.
+void profile_reset()
+{
+    for (CycleHistogram& h : histograms) { h = CycleHistogram(); }
+}
+
+void print_profile()
+{
+    Serial.print("Profile, cycles at "); Serial.print(getCpuFrequencyMhz()); Serial.println(" MHz");
+    Serial.println("stage,count,min,mean,p50,p99,max");
+    for (int s = 0; s < PROF_STAGES; s++)
+    {
+        const CycleHistogram& h = histograms[s];
+        if (h.count == 0) { continue; }
+        Serial.print(STAGE_NAMES[s]); Serial.print(",");
+        Serial.print((unsigned long)h.count); Serial.print(",");
+        Serial.print((unsigned long)h.min); Serial.print(",");
+        Serial.print((float)((double)h.sum / (double)h.count), 1); Serial.print(",");
+        Serial.print((unsigned long)h.percentile(0.5f)); Serial.print(",");
+        Serial.print((unsigned long)h.percentile(0.99f)); Serial.print(",");
+        Serial.println((unsigned long)h.max);
+    }
+
+    // Buckets as "stage: 2^b:count ...", empty buckets skipped.
+    for (int s = 0; s < PROF_STAGES; s++)
+    {
+        const CycleHistogram& h = histograms[s];
+        if (h.count == 0) { continue; }
+        Serial.print(STAGE_NAMES[s]); Serial.print(":");
+        for (int b = 0; b < PROFILE_BUCKETS; b++)
+        {
+            if (!h.buckets[b]) { continue; }
+            Serial.print(" 2^"); Serial.print(b); Serial.print(":"); Serial.print((unsigned long)h.buckets[b]);
+        }
+        Serial.println();
+    }
+}
+
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+#include <Arduino.h>
+#include "Trace.h"
+
+//#define PROFILING // Cycle histograms for the PROFILE_SCOPE probes. Without it the probes compile to nothing.
+
+#define PROFILE_BUCKETS 32 // bucket b holds durations of [2^b, 2^(b+1)) cycles, bucket 0 also 0
+
+enum ProfileStage : uint8_t {
+    PROF_CALCULATE,
+    PROF_CAPTURE_WINDOW,
+    PROF_PROCESS_WINDOW,
+    PROF_FETCH,
+    PROF_HANDLE,
+    PROF_SYNC_INDICIES,
+    PROF_SOLVE,
+    PROF_ANALYZE,
+    PROF_NORMALIZE,
+    PROF_INTERPOLATE,
+    PROF_CORRELATE,
+    PROF_LINE_FIT,
+    PROF_STAGES
+};
+
+// Log2 histogram of durations in CPU cycles. One writer per stage (every stage runs on one
+// task); readers on other cores may see a histogram that is one sample behind.
+struct CycleHistogram {
+    uint32_t buckets[PROFILE_BUCKETS] = {};
+    uint32_t count = 0;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint64_t sum = 0;
+
+    inline void add(uint32_t cycles)
+    {
+        buckets[31 - __builtin_clz(cycles | 1)]++;
+        count++;
+        sum += cycles;
+        if (cycles < min) { min = cycles; }
+        if (cycles > max) { max = cycles; }
+    }
+
+    // Upper bound of the bucket holding the p-th fraction (0..1) of the samples.
+    uint32_t percentile(float p) const;
+};
+
+const char* profile_stage_name(ProfileStage stage);
+
+// Times its scope with the cycle counter. out, when given, receives the duration whether or
+// not PROFILING is defined, for callers that report it themselves (StageTimings). With
+// TRACING the scope is also a trace scope named after the stage.
+struct ProfileScope {
+    inline ProfileScope(ProfileStage stage, uint32_t* out = nullptr) : stage(stage), out(out), start(ESP.getCycleCount())
+    {
+        #ifdef TRACING
+        trace_event(profile_stage_name(stage), 'B');
+        #endif
+    }
+    inline ~ProfileScope()
+    {
+        uint32_t cycles = ESP.getCycleCount() - start;
+        if (out) { *out = cycles; }
+        #ifdef PROFILING
+        profile_record(stage, cycles);
+        #endif
+        #ifdef TRACING
+        trace_event(profile_stage_name(stage), 'E');
+        #endif
+    }
+
+    static void profile_record(ProfileStage stage, uint32_t cycles);
+
+    ProfileStage stage;
+    uint32_t* out;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// PROFILE_SCOPE(stage): histogram and trace only, nothing at all without PROFILING or TRACING.
+// PROFILE_SCOPE_INTO(stage, out): always stores the duration in out, histogram with PROFILING.
+#if defined(PROFILING) || defined(TRACING)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(stage)
+#else
+#define PROFILE_SCOPE(stage) do {} while (0)
+#endif
+#define PROFILE_SCOPE_INTO(stage, out) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(stage, &(out))
+
+#ifdef PROFILING
+const CycleHistogram& profile_histogram(ProfileStage stage);
+void profile_reset();
+void print_profile(); // count, min, mean, p50, p99 and max per stage, then the non-empty buckets
+#endif
@@ -0,0 +1,181 @@
+#include "QuadCapture.h"
+
+#ifdef QUAD_CAPTURE
+#include "FrameCounter.h"
+#include "Solver.h"
+#include "DirectionSolver.h"
+
+#ifdef WINDOW_SAMPLES_VIEW
+#error "QUAD_CAPTURE solves float windows, drop BFP_WINDOW_BITS and FIXED_POINT_PIPELINE"
+#endif
+
+#define QUAD_DRAIN_TICKS 1 // loop wake-up between triggers, short enough that neither ring fills
+
+// Both I2S ports of the ESP32. Port A is the master and drives BCLK and LRCLK as in
+// Sampler::begin(); port B is a slave on the same two pins with its own data input, so
+// both converters are clocked by the same edges. The FrameCounter counts LRCLK as in
+// Sampler (wired to GPIO_NUM_14).
+class I2SQuadSource {
+    public:
+    SampleClock clock; // rate of both ports, as Sampler::clock; set before begin()
+
+    void set_pins(gpio_num_t bclk, gpio_num_t lrclk, gpio_num_t data_a, gpio_num_t data_b, gpio_num_t sync_pulse)
+    {
+        bclk_pin = bclk; lrclk_pin = lrclk; data_pin[0] = data_a; data_pin[1] = data_b; sync_pulse_pin = sync_pulse;
+    }
+
+    bool begin()
+    {
+        pinMode(sync_pulse_pin, OUTPUT);
+        digitalWrite(sync_pulse_pin, LOW);
+
+        if (!install(I2S_PORT, I2S_MODE_MASTER, data_pin[0])) { return false; }
+        if (!install(I2S_PORT_B, I2S_MODE_SLAVE, data_pin[1])) { return false; }
+
+        // i2s_set_pin() of the slave made the shared pins inputs; give port A its outputs back.
+        gpio_set_direction(bclk_pin, GPIO_MODE_INPUT_OUTPUT);
+        gpio_set_direction(lrclk_pin, GPIO_MODE_INPUT_OUTPUT);
+
+        if (!frameCounter.begin(GPIO_NUM_14)) { return false; }
+
+        // The slave first, so it sees the first clock the master sends.
+        i2s_start(I2S_PORT_B);
+        i2s_start(I2S_PORT);
+        return true;
+    }
+
+    uint64_t write_index() const { return frameCounter.get(); }
+
+    void wait_frames(uint32_t n) { delayMicroseconds((uint32_t)(n * clock.frame_us())); }
+
+    size_t read(int port, uint8_t* buf, size_t frames)
+    {
+        size_t bytes_read = 0;
+        i2s_port_t i2s_port = (port == 0) ? I2S_PORT : I2S_PORT_B;
+        if (i2s_read(i2s_port, buf, frames * BYTES_PER_FRAME, &bytes_read, portMAX_DELAY) != ESP_OK) { return 0; }
+        size_t frames_read = bytes_read / BYTES_PER_FRAME;
+        fix_slot_order(buf, frames_read);
+        return frames_read;
+    }
+
+    // As Sampler::send_sync_pulse(). The pulse transistor pulls the left input of both converters.
+    void pulse()
+    {
+        for (int n = 0; n < SYNC_PULSE_CODE_LEN; n++)
+        {
+            digitalWrite(sync_pulse_pin, SYNC_PULSE_CODE[n]);
+            delayMicroseconds(SYNC_FRAMES_PER_PULSE * clock.frame_us());
+        }
+        digitalWrite(sync_pulse_pin, LOW);
+    }
+
+    private:
+    bool install(i2s_port_t port, int role, gpio_num_t data_in)
+    {
+        i2s_config_t cfg = {};
+        cfg.mode                 = (i2s_mode_t)(role | I2S_MODE_RX);
+        cfg.sample_rate          = clock.hz;
+        cfg.bits_per_sample      = BITS_PER_SAMPLE;
+        cfg.channel_format       = I2S_CHANNEL_FMT_RIGHT_LEFT;
+        cfg.communication_format = (i2s_comm_format_t)I2S_COMM_FORMAT_I2S;
+        cfg.intr_alloc_flags     = ESP_INTR_FLAG_LEVEL1;
+        cfg.dma_buf_count        = DMA_BUF_COUNT;
+        cfg.dma_buf_len          = DMA_BUF_LEN;
+        cfg.use_apll             = (role == I2S_MODE_MASTER);
+        cfg.tx_desc_auto_clear   = false;
+        cfg.fixed_mclk           = 0;
+
+        i2s_pin_config_t pins = {};
+        pins.bck_io_num   = bclk_pin;
+        pins.ws_io_num    = lrclk_pin;
+        pins.data_out_num = I2S_PIN_NO_CHANGE;
+        pins.data_in_num  = data_in;
+
+        if (i2s_driver_install(port, &cfg, 0, nullptr) != ESP_OK) { return false; }
+        if (i2s_set_pin(port, &pins) != ESP_OK) { return false; }
+        if (i2s_set_clk(port, clock.hz, BITS_PER_SAMPLE, I2S_CHANNEL_STEREO) != ESP_OK) { return false; }
+        i2s_stop(port);
+        return true;
+    }
+
+    gpio_num_t bclk_pin, lrclk_pin, data_pin[QUAD_PORTS], sync_pulse_pin;
+    FrameCounter frameCounter;
+};
+
+typedef BasicQuadSampler<I2SQuadSource> QuadSampler;
+
+static QuadSampler quad_sampler;
+static QuadWindow quad_window;
+static float quad_pair[CHANNELS * FRAMES_PER_SIGNAL];
+static volatile uint64_t quad_trigger_index = 0;
+static volatile bool quad_triggered = false;
+
+static void IRAM_ATTR on_quad_trigger()
+{
+    if (quad_triggered) { return; }
+    quad_trigger_index = quad_sampler.source.write_index();
+    quad_triggered = true;
+}
+
+// The pairs printed for every window: both ports' own pairs and four across the ports.
+static const int QUAD_PAIRS[][2] = { { 0, 1 }, { 2, 3 }, { 0, 2 }, { 0, 3 }, { 1, 2 }, { 1, 3 } };
+
+void run_quad_capture(gpio_num_t bclk, gpio_num_t lrclk, gpio_num_t data_a, gpio_num_t data_b, gpio_num_t sync_pulse, int trigger_pin)
+{
+    const SampleClock& clock = quad_sampler.source.clock;
+    quad_sampler.source.set_pins(bclk, lrclk, data_a, data_b, sync_pulse);
+    for (NoiseFloor& noise : quad_sampler.noise_floor) { noise.alpha = clock.per_frame(NOISE_FLOOR_ALPHA); }
+    if (!quad_sampler.begin())
+    {
+        Serial.println("QuadSampler.begin FAILED");
+        while (true) { delay(1000); }
+    }
+    Serial.println("QuadSampler synced");
+
+    pinMode(trigger_pin, INPUT_PULLDOWN);
+    attachInterrupt(digitalPinToInterrupt(trigger_pin), on_quad_trigger, RISING);
+
+    Solver solver;
+    solver.set_sample_rate(clock.hz);
+    DirectionSolver<QUAD_CHANNELS> direction(QUAD_MIC_POSITIONS);
+    direction.slip_us = 1e6f / CARRIER_HZ;
+    while (true)
+    {
+        if (!quad_triggered)
+        {
+            if (!quad_sampler.drain()) { Serial.println("QuadSampler resync FAILED"); }
+            vTaskDelay(QUAD_DRAIN_TICKS);
+            continue;
+        }
+
+        quad_window.trigger_index = quad_trigger_index;
+        bool captured = quad_sampler.capture(quad_trigger_index, quad_window);
+        quad_triggered = false;
+        if (!captured) { Serial.println("Quad capture missed the trigger"); continue; }
+
+        TdoaPair tdoa[sizeof(QUAD_PAIRS) / sizeof(QUAD_PAIRS[0])];
+        size_t n_tdoa = 0;
+        for (const int* pair : QUAD_PAIRS)
+        {
+            float thresholds[CHANNELS], t_diff, sig_delay;
+            Measurement m;
+            quad_window.pair(pair[0], pair[1], quad_pair, thresholds);
+            solver.set_thresholds(thresholds);
+            bool ok = solver.solve(quad_pair, quad_window.n_frames, t_diff, sig_delay, m);
+
+            Serial.print(pair[0]); Serial.print("-"); Serial.print(pair[1]); Serial.print(": ");
+            if (ok) { Serial.print(t_diff, 3); Serial.print(" us  "); }
+            else { Serial.print("failed  "); continue; }
+            tdoa[n_tdoa++] = TdoaPair{ (uint8_t)pair[0], (uint8_t)pair[1], t_diff, m.confidence };
+        }
+        Serial.println();
+
+        Direction d;
+        if (!direction.solve(tdoa, n_tdoa, d)) { Serial.println("direction failed"); continue; }
+        Serial.print("azimuth "); Serial.print(d.azimuth, 2);
+        Serial.print(" deg, elevation "); Serial.print(d.elevation, 2);
+        Serial.print(" deg, residual "); Serial.print(d.residual_us, 3);
+        Serial.print(" us, slipped pairs "); Serial.println(d.slipped);
+    }
+}
+#endif
@@ -0,0 +1,221 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "Sampler_settings.h"
+#include "FrameDecode.h"
+#include "NoiseFloor.h"
+#include "SignalAnalyzer.h"
+#include "SyncCode.h"
+
+//#define QUAD_CAPTURE // Run the four microphone array on both I2S ports from setup() instead of the stereo pipeline.
+
+#define QUAD_PORTS 2
+#define QUAD_CHANNELS (QUAD_PORTS * CHANNELS) // port A L, R, port B L, R
+#define QUAD_ARRAY_RADIUS_M 0.05f
+#define QUAD_PORT_B_HEIGHT_M 0.07f
+
+static const i2s_port_t I2S_PORT_B = I2S_NUM_1;
+
+// Microphone positions in m, x right, y forward, z up, in QuadWindow channel order. Port A
+// is the stereo pair of Sampler; port B is a second pair across it, raised so the four are
+// not coplanar. No two are more than 2 * QUAD_ARRAY_RADIUS_M apart, so every pair fits the
+// MAX_CHANNEL_LAG of Solver.
+static const float QUAD_MIC_POSITIONS[QUAD_CHANNELS][3] = {
+    { -QUAD_ARRAY_RADIUS_M, 0.0f, 0.0f },
+    { QUAD_ARRAY_RADIUS_M, 0.0f, 0.0f },
+    { 0.0f, -QUAD_ARRAY_RADIUS_M, QUAD_PORT_B_HEIGHT_M },
+    { 0.0f, QUAD_ARRAY_RADIUS_M, QUAD_PORT_B_HEIGHT_M },
+};
+
+// One four channel window, QUAD_CHANNELS interleaved samples per frame, in volts. Frame i of
+// every channel is the same instant: first_index + i on the FrameCounter timeline.
+struct QuadWindow {
+    float frames[QUAD_CHANNELS * FRAMES_PER_SIGNAL];
+    size_t n_frames = 0;
+    uint64_t trigger_index = 0;  // emission the window is timed against
+    uint64_t first_index = 0;    // timeline index of frames[0]
+    float threshold[QUAD_CHANNELS]; // detection thresholds from the noise floor at capture time
+
+    // Channels a and b as interleaved L, R frames, the layout Solver::solve() reads; t_diff
+    // is then the arrival at b minus the arrival at a.
+    void pair(int a, int b, float* out, float* thresholds) const
+    {
+        for (size_t i = 0; i < n_frames; i++)
+        {
+            out[2 * i] = frames[i * QUAD_CHANNELS + a];
+            out[2 * i + 1] = frames[i * QUAD_CHANNELS + b];
+        }
+        thresholds[0] = threshold[a];
+        thresholds[1] = threshold[b];
+    }
+};
+
+// Both I2S ports of the array in lockstep on one frame timeline. The ports share BCLK and
+// LRCLK, so a frame index is the same instant on both and one FrameCounter times them; only
+// the frame where each DMA stream started differs. sync() measures that for each port with
+// the sync pulse, which is wired to the left input of both converters. From then on
+// read_index[p] is the timeline index of the next frame port p delivers, and capture()
+// reads the same frames from both.
+//
+// Source is the hardware: I2SQuadSource (QuadCapture.cpp) on the target, SimQuadSource
+// (host/SimQuadSource.h) on the host. It provides
+//   begin()                  - starts both ports
+//   write_index()            - frames clocked so far, the FrameCounter timeline
+//   wait_frames(n)           - lets about n frames pass
+//   read(port, buf, frames)  - the next frames of one port, BYTES_PER_FRAME raw slots each; returns the count
+//   pulse()                  - sends the sync pulse code, starting at write_index()
+template <class Source>
+class BasicQuadSampler {
+    public:
+    bool begin()
+    {
+        if (!source.begin()) { return false; }
+        read_index[0] = read_index[1] = source.write_index();
+        return sync();
+    }
+
+    // Finds the sync pulse in both ports and sets their read indices to the timeline.
+    bool sync()
+    {
+        float baseline[QUAD_PORTS];
+        for (int p = 0; p < QUAD_PORTS; p++)
+        {
+            size_t n = read_port(p, FRAMES_PER_READ);
+            if (n < 10) { return false; }
+            baseline[p] = 0.0f;
+            for (size_t j = 0; j < n; j++) { baseline[p] += sample(j, 0); }
+            baseline[p] /= (float)n;
+        }
+
+        uint64_t sync_index = source.write_index();
+        source.pulse();
+
+        // The other port's ring keeps the pulse while one port is searched.
+        for (int p = 0; p < QUAD_PORTS; p++)
+        {
+            size_t kept = 0, total = 0;
+            bool found = false;
+            while (!found && total < DMA_BUF_COUNT * DMA_BUF_LEN)
+            {
+                size_t n = read_port(p, FRAMES_PER_READ);
+                if (n == 0) { return false; }
+                total += n;
+                for (size_t j = 0; j < n; j++) { sync_buf[kept + j] = sample(j, 0); }
+
+                size_t offset;
+                unsigned int score;
+                found = find_sync_code(sync_buf, kept + n, baseline[p], offset, score);
+                if (found)
+                {
+                    uint64_t code_index = read_index[p] - (uint64_t)(kept + n - offset);
+                    read_index[p] += sync_index - code_index;
+                    break;
+                }
+
+                // Keep the tail, the code may straddle two reads.
+                size_t n_total = kept + n;
+                kept = (n_total < SYNC_CODE_TOTAL_LEN) ? n_total : SYNC_CODE_TOTAL_LEN;
+                memmove(sync_buf, sync_buf + n_total - kept, kept * sizeof(float));
+            }
+            if (!found) { return false; }
+        }
+        return true;
+    }
+
+    // Reads both ports up to the newest complete block, for the noise floors. Resyncs when a
+    // ring overflowed, its frames no longer follow read_index.
+    bool drain()
+    {
+        for (int p = 0; p < QUAD_PORTS; p++)
+        {
+            if (source.write_index() - read_index[p] >= (uint64_t)(DMA_BUF_LEN * DMA_BUF_COUNT)) { return sync(); }
+        }
+        for (int p = 0; p < QUAD_PORTS; p++)
+        {
+            while (source.write_index() - read_index[p] >= (uint64_t)(FRAMES_PER_READ + SAFE_FRAME_READ_DIFF))
+            {
+                discard(p, FRAMES_PER_READ);
+            }
+        }
+        return true;
+    }
+
+    // FRAMES_PER_SIGNAL frames from start_index on, from both ports. False when start_index
+    // was already read past, or a port delivered less than asked.
+    bool capture(uint64_t start_index, QuadWindow& window)
+    {
+        for (int p = 0; p < QUAD_PORTS; p++)
+        {
+            if (read_index[p] > start_index) { return false; }
+            discard(p, (size_t)(start_index - read_index[p]));
+        }
+        for (int c = 0; c < QUAD_CHANNELS; c++) { window.threshold[c] = SignalAnalyzer::noise_threshold(noise_floor[c]); }
+
+        window.first_index = start_index;
+        window.n_frames = 0;
+        while (window.n_frames < FRAMES_PER_SIGNAL)
+        {
+            size_t want = FRAMES_PER_SIGNAL - window.n_frames;
+            if (want > FRAMES_PER_READ) { want = FRAMES_PER_READ; }
+
+            // One block of each port in turn, so neither ring runs ahead.
+            for (int p = 0; p < QUAD_PORTS; p++)
+            {
+                if (read_port(p, want) != want) { return false; }
+                float* out = window.frames + window.n_frames * QUAD_CHANNELS + p * CHANNELS;
+                for (size_t j = 0; j < want; j++, out += QUAD_CHANNELS)
+                {
+                    for (int c = 0; c < CHANNELS; c++) { out[c] = sample(j, c); }
+                }
+            }
+            window.n_frames += want;
+        }
+        return true;
+    }
+
+    Source source;
+    uint64_t read_index[QUAD_PORTS] = {};
+    NoiseFloor noise_floor[QUAD_CHANNELS]; // Fed by discarded frames, as in Sampler
+
+    private:
+    // Waits like Sampler::read_frames() until the frames are safely in the ring.
+    size_t read_port(int port, size_t frames)
+    {
+        while (true)
+        {
+            int64_t overhead = (int64_t)(source.write_index() - read_index[port]) - (int64_t)frames - SAFE_FRAME_READ_DIFF;
+            if (overhead > 0) { break; }
+            source.wait_frames((uint32_t)(-overhead) + 1);
+        }
+        size_t n = source.read(port, raw, frames);
+        read_index[port] += n;
+        return n;
+    }
+
+    void discard(int port, size_t frames)
+    {
+        while (frames > 0)
+        {
+            size_t n = read_port(port, (frames > FRAMES_PER_READ) ? FRAMES_PER_READ : frames);
+            if (n == 0) { return; }
+            for (size_t j = 0; j < n; j++)
+            {
+                for (int c = 0; c < CHANNELS; c++) { noise_floor[port * CHANNELS + c].update(sample(j, c)); }
+            }
+            frames -= n;
+        }
+    }
+
+    // Channel c of frame j of the last read, volts.
+    inline float sample(size_t j, int c) const { return code_to_voltage(read_slot(raw + (j * CHANNELS + c) * BYTES_PER_SAMPLE)); }
+
+    uint8_t raw[FRAMES_PER_READ * BYTES_PER_FRAME];
+    float sync_buf[FRAMES_PER_READ + SYNC_CODE_TOTAL_LEN];
+};
+
+#ifdef QUAD_CAPTURE
+// Measures from both ports on every trigger and prints the pair time differences and the
+// direction DirectionSolver finds from them. Never returns.
+void run_quad_capture(gpio_num_t bclk, gpio_num_t lrclk, gpio_num_t data_a, gpio_num_t data_b, gpio_num_t sync_pulse, int trigger_pin);
+#endif
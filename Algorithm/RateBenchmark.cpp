@@ -0,0 +1,73 @@
+#include "RateBenchmark.h"
+
+#ifdef RATE_BENCHMARK
+
+#include <Arduino.h>
+#include "Algorithm.h"
+
+// Share of core 0 that the capture loop needs to keep up with the converter, at each rate:
+// the cycles spent in handle() and capture_window() over the wall time, with one tick of
+// sleep between passes as in captureTask. Triggered mode drains the ring and feeds the noise
+// floor; free-running mode also decodes every frame for the onset detector. The work per
+// analysed window does not depend on the rate, only on how often windows open, so it is
+// not counted: windows opened by noise are analysed outside the timed passes. At the idle
+// rate nothing is measured, so that row is the cost of listening alone; onsets heard there
+// are counted instead of waking the capture up.
+static void bench_mode(Algorithm& algorithm, uint32_t hz, bool free_running)
+{
+    algorithm.request_sample_rate(hz);
+    algorithm.handle();
+    algorithm.set_free_running(free_running);
+    algorithm.discard_frames((size_t)algorithm.clock.frames_ms(100));
+    algorithm.idle_onsets = 0;
+
+    uint64_t busy = 0;
+    uint32_t passes = 0, windows = 0;
+    uint64_t first_index = algorithm.readIndex;
+    unsigned long start_us = micros();
+    while (micros() - start_us < RATE_BENCH_MS * 1000UL)
+    {
+        uint32_t c0 = ESP.getCycleCount();
+        algorithm.capture_window();
+        algorithm.handle();
+        busy += ESP.getCycleCount() - c0;
+        passes++;
+
+        while (algorithm.window_ready())
+        {
+            float angle, distance;
+            algorithm.process_window(angle, distance);
+            windows++;
+        }
+        vTaskDelay(1);
+    }
+    unsigned long wall_us = micros() - start_us;
+    uint64_t frames = algorithm.readIndex - first_index;
+
+    Serial.print(hz); Serial.print(",");
+    Serial.print(free_running ? "free_running" : "triggered"); Serial.print(",");
+    Serial.print((double)busy / (double)getCpuFrequencyMhz() / (double)wall_us * 100.0, 2); Serial.print(",");
+    Serial.print((double)busy / (double)frames, 1); Serial.print(",");
+    Serial.print((double)frames * 1e6 / (double)wall_us, 0); Serial.print(",");
+    Serial.print(passes); Serial.print(",");
+    Serial.print(windows); Serial.print(",");
+    Serial.println(algorithm.idle_onsets);
+}
+
+void run_rate_benchmark(Algorithm& algorithm)
+{
+    Serial.println("rate_hz,mode,load_pct,cycles_per_frame,frames_per_s,passes,windows,idle_onsets");
+    algorithm.wake_from_idle = false;
+    const uint32_t rates[] = { SAMPLE_RATE, IDLE_SAMPLE_RATE_HZ };
+    for (uint32_t hz : rates)
+    {
+        bench_mode(algorithm, hz, false);
+        bench_mode(algorithm, hz, true);
+    }
+    algorithm.set_free_running(false);
+    algorithm.wake_from_idle = true;
+    algorithm.request_sample_rate(SAMPLE_RATE);
+    algorithm.handle();
+}
+
+#endif
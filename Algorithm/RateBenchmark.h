@@ -0,0 +1,11 @@
+#pragma once
+
+class Algorithm;
+
+//#define RATE_BENCHMARK // Measure the capture core's load at SAMPLE_RATE and while listening at IDLE_SAMPLE_RATE_HZ from setup() instead of measuring.
+
+#define RATE_BENCH_MS 5000 // per rate and mode
+
+#ifdef RATE_BENCHMARK
+void run_rate_benchmark(Algorithm& algorithm);
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+#define SAMPLE_RATE_HZ 192000     // Precision captures: the rate at boot, the highest rate, the one the analysis is tuned for
+// Low power listening only. ENERGY_WINDOW, the CFAR cells and AnalysisParams are frames tuned
+// at SAMPLE_RATE_HZ, so nothing is measured at this rate: the onset detector and the trigger
+// still run, and the first onset or trigger switches back to SAMPLE_RATE_HZ, see
+// Algorithm::request_sample_rate(). That burst is not measured, the next one is.
+#define IDLE_SAMPLE_RATE_HZ 96000
+#define SAMPLE_T_US (1e6f / (float)SAMPLE_RATE_HZ) // us per frame at SAMPLE_RATE_HZ, for the benchmarks and host tools
+
+// The capture rate and every conversion between frames and time. Code that runs at the
+// current rate converts through the clock of the Sampler or of the window, never through
+// SAMPLE_T_US, so a rate change reaches all of it.
+struct SampleClock {
+    uint32_t hz = SAMPLE_RATE_HZ;
+
+    float frame_us() const { return 1e6f / (float)hz; }
+    uint64_t frames_ms(uint32_t ms) const { return (uint64_t)hz * ms / 1000; }
+
+    // A per frame constant tuned at SAMPLE_RATE_HZ, with the same time constant at this rate.
+    float per_frame(float at_full_rate) const { return at_full_rate * (float)SAMPLE_RATE_HZ / (float)hz; }
+};
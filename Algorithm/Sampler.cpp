@@ -13,7 +13,7 @@ bool Sampler::begin()
     i2s_config_t cfg = {};
     cfg.mode                 = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX);
     cfg.sample_rate          = SAMPLE_RATE;
-    cfg.bits_per_sample      = I2S_BITS_PER_SAMPLE_32BIT;
+    cfg.bits_per_sample      = BITS_PER_SAMPLE;
     cfg.channel_format       = I2S_CHANNEL_FMT_RIGHT_LEFT;
     cfg.communication_format = (i2s_comm_format_t)I2S_COMM_FORMAT_I2S;
     cfg.intr_alloc_flags     = ESP_INTR_FLAG_LEVEL1;
@@ -31,7 +31,7 @@ bool Sampler::begin()
 
     if (i2s_driver_install(I2S_PORT, &cfg, 0, nullptr) != ESP_OK) return false;
     if (i2s_set_pin(I2S_PORT, &pins) != ESP_OK) return false;
-    if (i2s_set_clk(I2S_PORT, SAMPLE_RATE, I2S_BITS_PER_SAMPLE_32BIT, I2S_CHANNEL_STEREO) != ESP_OK) return false;
+    if (i2s_set_clk(I2S_PORT, SAMPLE_RATE, BITS_PER_SAMPLE, I2S_CHANNEL_STEREO) != ESP_OK) return false;
 
     if (!frameCounter.begin(GPIO_NUM_14)) {
         return false;
@@ -41,9 +41,29 @@ bool Sampler::begin()
     return true;
 }
 
+bool Sampler::set_sample_rate(uint32_t hz)
+{
+    if (hz == 0 || hz > (uint32_t)SAMPLE_RATE) { return false; }
+    if (hz == clock.hz) { return true; }
+    if (i2s_set_clk(I2S_PORT, hz, BITS_PER_SAMPLE, I2S_CHANNEL_STEREO) != ESP_OK) { return false; }
+
+    clock.hz = hz;
+    for (int c = 0; c < CHANNELS; c++) { noise_floor[c].alpha = clock.per_frame(NOISE_FLOOR_ALPHA); }
+    correction.configure(calibration, hz);
+
+    // The ring restarted empty: read from now on, let the converter settle, then find the
+    // exact offset again with the sync pulse.
+    readIndex = frameCounter.get();
+    discard_frames((size_t)clock.frames_ms(SAMPLE_RATE_SETTLE_MS));
+    bool synced = sync_indicies();
+    LOG(LOG_SAMPLE_RATE, hz, (int32_t)synced);
+    return true;
+}
+
 // Not used in derived Algorithm class.
 void Sampler::handle()
 {   
+    PROFILE_SCOPE(PROF_HANDLE);
     static unsigned long last_millis = millis();
     static uint64_t last_index = frameCounter.get();
     unsigned long now = millis();
@@ -51,7 +71,7 @@ void Sampler::handle()
     if (now - last_millis >= RESYNC_READINDEX_MS) {
       #ifdef SAMPLER_DEBUG
       uint64_t index = frameCounter.get();
-      Serial.print("LRCLK freq: "); Serial.println((index - last_index) / (now - last_millis));
+      LOG(LOG_LRCLK_FREQ, (uint64_t)((index - last_index) / (now - last_millis)));
       last_index = index;
       #endif
       sync_indicies(); last_millis = now;
@@ -74,8 +94,10 @@ void Sampler::trigger()
     triggered = true;
 }
 
-size_t Sampler::fetch(float* l_buf, float* r_buf, uint16_t* offset, bool discard_first)
+// Fills frames with FRAMES_PER_SIGNAL interleaved frames (L, R, L, R, ...).
+size_t Sampler::fetch(WindowFrames& frames, uint16_t* offset, bool discard_first)
 {
+    PROFILE_SCOPE(PROF_FETCH);
     if (!triggered) { return 0; }
     
 
@@ -95,26 +117,31 @@ size_t Sampler::fetch(float* l_buf, float* r_buf, uint16_t* offset, bool discard
 
     uint64_t snapshot = frameCounter.get();
     
-    size_t total_frames_read = 0;
-    size_t frames_left = FRAMES_PER_SIGNAL;
+    noise_tracking = false; // The window holds the burst.
+    frames.clear();
     int count = 0;
-    while (total_frames_read < FRAMES_PER_SIGNAL)
+    while (frames.size() < FRAMES_PER_SIGNAL)
     {
-        size_t frames_read = read_samples(l_buf + total_frames_read, r_buf + total_frames_read);
+        size_t room;
+        WindowFrames::Sample* frame_buf = frames.stage(room);
+        size_t frames_read = read_interleaved(frame_buf, room);
         if (frames_read == 0) { break; }
-        total_frames_read += frames_read;
+        frames.commit(frames_read);
         count++;
-        if (count > 10000) { Serial.println("STUCK"); while(true); }
+        if (count > 10000) { LOG(LOG_FETCH_STUCK); while(true); }
     }
+    frames.finish();
     
+    noise_tracking = true;
     triggered = false;
-    return total_frames_read;
+    return frames.size();
 }
 
 size_t Sampler::discard_frames(size_t frames_to_discard)
 {
+    TRACE_SCOPE("discard");
     size_t total_frames_discarded = 0;
-    static uint8_t dummy[FRAMES_PER_READ * BYTES_PER_FRAME];
+    uint8_t* dummy = hot_arena.raw;
 
     while (total_frames_discarded < frames_to_discard)
     {
@@ -122,6 +149,8 @@ size_t Sampler::discard_frames(size_t frames_to_discard)
         if (frames_to_read > FRAMES_PER_READ) { frames_to_read = FRAMES_PER_READ; }
         
         size_t frames_read = read_frames(frames_to_read, dummy);
+        track_noise(frames_read, dummy);
+        if (correction.enabled) { prime_correction(frames_read, dummy); }
         total_frames_discarded += frames_read;
     }
     return total_frames_discarded;
@@ -133,7 +162,7 @@ void Sampler::send_sync_pulse()
     for (int n = 0; n < SYNC_PULSE_CODE_LEN; n++)
     {
         digitalWrite(sync_pulse_pin, SYNC_PULSE_CODE[n]);
-        delayMicroseconds(SYNC_FRAMES_PER_PULSE * SAMPLE_T_US);
+        delayMicroseconds(SYNC_FRAMES_PER_PULSE * clock.frame_us());
     }
     digitalWrite(sync_pulse_pin, LOW);
 
@@ -162,48 +191,24 @@ uint64_t Sampler::send_sync_pulse()
 
 bool Sampler::find_sync_pulse(size_t n_samples, float* buf, uint64_t sync_index, float baseline)
 {
-    // Make array for code.
-    static bool code[SYNC_CODE_TOTAL_LEN];
-    static bool first = false;
-    if (!first)
-    {
-        first = true;
-        for (int l = 0; l < SYNC_PULSE_CODE_LEN; l++)
-        {
-            for (int u = 0; u < SYNC_FRAMES_PER_PULSE; u++)
-            {
-                code[l * SYNC_FRAMES_PER_PULSE + u] = SYNC_PULSE_CODE[l];
-            }
-        }
-    }
-
-    unsigned int best_score_offset, best_score = SYNC_CODE_TOTAL_LEN;
+    size_t best_score_offset;
+    unsigned int best_score;
+    if (!find_sync_code(buf, n_samples, baseline, best_score_offset, best_score)) { return false; }
 
-    for (int l = 0; l <= n_samples - SYNC_CODE_TOTAL_LEN; l++)
-    {   
-        unsigned int score = SYNC_CODE_TOTAL_LEN;
-        for (int u = 0; u < SYNC_CODE_TOTAL_LEN; u++)
-        {
-            bool bit_meas = ((buf[l + u] - baseline) < -SYNC_PULSE_THRESHOLD);
-            if (bit_meas == code[u]) { score--; }
-        }
-        if (score < best_score) { best_score = score; best_score_offset = l; }
-    }
-    if (best_score > SYNC_SCORE_DIFF_THRESHOLD) { return false; }
-    
     uint64_t sampleIndex = readIndex - (uint64_t)(n_samples - (size_t)best_score_offset);
     int64_t correction = (int64_t)sync_index - (int64_t)sampleIndex;
     readIndex = (uint64_t)((int64_t)readIndex + correction);
     #ifdef SAMPLER_DEBUG
-    Serial.print("Best sync score: "); Serial.println(best_score);
+    LOG(LOG_SYNC_SCORE, (int32_t)best_score);
     #endif
     return true;
 }
 
 bool Sampler::sync_indicies()
 {
-    float buf[FRAMES_PER_READ + SYNC_CODE_TOTAL_LEN];
-    float dummy[FRAMES_PER_READ];
+    PROFILE_SCOPE(PROF_SYNC_INDICIES);
+    float* buf = hot_arena.sync;
+    float* dummy = hot_arena.sync_other;
     size_t samples_read, sync_write_index = 0;
 
     // Get baseline value
@@ -256,16 +261,8 @@ bool Sampler::sync_indicies()
     }
 
     #ifdef SYNC_DEBUG
-    if (found_sync) {
-        Serial.print("[Sampler::sync_indicies] readIndex diff: ");
-        Serial.print((signed long)(readIndex - old_readIndex));
-    } else {
-        Serial.print("[Sampler::sync_indicies] sync pulse NOT found. read frames: ");
-        Serial.print(total_samples_read);
-    }
-    Serial.print(", base: "); Serial.println(baseline, 6);
-    Serial.print("old read index: "); Serial.print(old_readIndex);
-    Serial.print(", sync index: "); Serial.println(sync_index);
+    if (found_sync) { LOG(LOG_SYNC_FOUND, (int32_t)(readIndex - old_readIndex), baseline, old_readIndex, sync_index); }
+    else { LOG(LOG_SYNC_NOT_FOUND, (uint32_t)total_samples_read, baseline, old_readIndex, sync_index); }
     #endif
 
     if (found_sync) { last_resync_millis = millis(); }
@@ -275,22 +272,44 @@ bool Sampler::sync_indicies()
 
 size_t Sampler::read_samples(float* l_buf, float* r_buf, TickType_t timeoutTicks)
 {
-    uint8_t frame_buf[FRAMES_PER_READ * BYTES_PER_FRAME];
+    uint8_t* frame_buf = hot_arena.raw;
     size_t frames_read = read_frames(FRAMES_PER_READ, frame_buf, timeoutTicks);
     if (frames_read == 0) { return 0; }
     to_voltage(frames_read, frame_buf, l_buf, r_buf);
     return frames_read;
 }
 
+size_t Sampler::read_interleaved(float* frame_buf, size_t frames, TickType_t timeoutTicks)
+{
+    uint8_t* raw_buf = hot_arena.raw;
+    if (frames > FRAMES_PER_READ) { frames = FRAMES_PER_READ; }
+    size_t frames_read = read_frames(frames, raw_buf, timeoutTicks);
+    if (frames_read == 0) { return 0; }
+    to_voltage(frames_read, raw_buf, frame_buf);
+    return frames_read;
+}
+
+// Q31 windows (WindowStorage.h): the same read, decoded without the float conversion.
+size_t Sampler::read_interleaved(q31_t* frame_buf, size_t frames, TickType_t timeoutTicks)
+{
+    uint8_t* raw_buf = hot_arena.raw;
+    if (frames > FRAMES_PER_READ) { frames = FRAMES_PER_READ; }
+    size_t frames_read = read_frames(frames, raw_buf, timeoutTicks);
+    if (frames_read == 0) { return 0; }
+    decode_frames_q31(frames_read, raw_buf, frame_buf, correction, noise_tracking ? noise_floor : nullptr);
+    return frames_read;
+}
+
 size_t Sampler::read_frames(size_t frames, uint8_t* buf, TickType_t timeoutTicks)
 {
     if (frames <= 0) { return 0; }
+    TRACE_SCOPE("i2s_read");
     int32_t overhead;
     while (true)
     {
         overhead = (int32_t)(frameCounter.get() - readIndex) - (int32_t)frames - SAFE_FRAME_READ_DIFF;
         if (overhead > 0) { break; }
-        delayMicroseconds((int)(abs(overhead) * SAMPLE_T_US));
+        delayMicroseconds((int)(abs(overhead) * clock.frame_us()));
     }
     
     size_t bytesToRead = (size_t)frames * BYTES_PER_FRAME;
@@ -299,14 +318,13 @@ size_t Sampler::read_frames(size_t frames, uint8_t* buf, TickType_t timeoutTicks
     if (err != ESP_OK || bytesRead == 0) { return 0; }
     size_t frames_read = bytesRead / BYTES_PER_FRAME;
     readIndex += (uint64_t)frames_read;
+    fix_slot_order(buf, frames_read);
     return frames_read;
 }
 
 void Sampler::discard_initial()
 {
-    const uint32_t settleFrames = SAMPLE_RATE / 10; // 100 ms
-
-    size_t discarded_frames = discard_frames((size_t)settleFrames);
+    size_t discarded_frames = discard_frames((size_t)clock.frames_ms(100));
 
     #ifdef SAMPLER_DEBUG
         Serial.print("[Sampler::discardInitialSettle] discarded_frames=");
@@ -319,22 +337,52 @@ void Sampler::to_voltage(size_t n_frames, uint8_t* input_buf, float* output_l, f
     if (n_frames == 0) { return; }
     for (size_t j = 0; j < n_frames; j++)
     {
-        // Each frame is 8 bytes: 4 left + 4 right
+        // Each frame is a left slot then a right slot
         const uint8_t* p = input_buf + j * BYTES_PER_FRAME;
-
-        // --- Little-endian decode ---
-        int32_t sample_l = (int32_t)p[0] | ((int32_t)p[1] << 8) | ((int32_t)p[2] << 16) | ((int32_t)p[3] << 24);
-        int32_t sample_r = (int32_t)p[4] | ((int32_t)p[5] << 8) | ((int32_t)p[6] << 16) | ((int32_t)p[7] << 24);
+        int32_t sample_l = read_slot(p);
+        int32_t sample_r = read_slot(p + BYTES_PER_SAMPLE);
         
         output_l[j] = sample_to_voltage(sample_l);
         output_r[j] = sample_to_voltage(sample_r);
     }
 }
 
+void Sampler::to_voltage(size_t n_frames, uint8_t* input_buf, float* output)
+{
+    decode_frames(n_frames, input_buf, output, correction, noise_tracking ? noise_floor : nullptr);
+}
+
+// Feeds raw frames to the noise floor estimators without keeping the decoded samples.
+void Sampler::track_noise(size_t n_frames, const uint8_t* input_buf)
+{
+    if (!noise_tracking) { return; }
+    // The gain only where the windows get it too, calibrate() keeps the old gains disabled.
+    const uint8_t* p = input_buf;
+    for (size_t j = 0; j < n_frames; j++)
+    {
+        for (int c = 0; c < CHANNELS; c++, p += BYTES_PER_SAMPLE)
+        {
+            float v = sample_to_voltage(read_slot(p));
+            noise_floor[c].update(correction.enabled ? v * correction.gain[c] : v);
+        }
+    }
+}
+
+// Keeps the correction FIR history continuous across discarded frames.
+void Sampler::prime_correction(size_t n_frames, const uint8_t* input_buf)
+{
+    size_t first = (n_frames > CALIBRATION_FIR_TAPS) ? n_frames - CALIBRATION_FIR_TAPS : 0;
+    const uint8_t* p = input_buf + first * BYTES_PER_FRAME;
+    for (size_t j = first; j < n_frames; j++)
+    {
+        for (int c = 0; c < CHANNELS; c++, p += BYTES_PER_SAMPLE)
+        {
+            correction.push(c, sample_to_voltage(read_slot(p)));
+        }
+    }
+}
+
 float Sampler::sample_to_voltage(int32_t input)
 {
-    const float CODE_FS       = 2147483648.0f;            // 2^31
-    const float VFS_DIFF_RMS  = 2.0f;                     // 2 Vrms differential
-    const float VFS_DIFF_PEAK = VFS_DIFF_RMS * 1.41421356237f;
-    return (float)input / CODE_FS * VFS_DIFF_PEAK;
+    return code_to_voltage(input);
 }
@@ -1,5 +1,12 @@
 #include "Sampler_settings.h"
 #include "FrameCounter.h"
+#include "NoiseFloor.h"
+#include "ChannelCalibration.h"
+#include "FrameDecode.h"
+#include "SyncCode.h"
+#include "HotArena.h"
+#include "Profiler.h"
+#include "LogRing.h"
 
 class Sampler {
     public:
@@ -8,10 +15,15 @@ class Sampler {
     bool begin();
     void handle();
     void trigger();
-    size_t fetch(float* l_buf, float* r_buf, uint16_t* offset, bool discard_first=false);
+    size_t fetch(WindowFrames& frames, uint16_t* offset, bool discard_first=false);
     void discard_initial();
     bool get_triggered_state() {return triggered; }
 
+    // Switches the I2S rate, hz <= SAMPLE_RATE, and everything timed by the clock. Restarts the
+    // DMA ring and resynchronizes the read index, so only the core that owns the reads may call it.
+    bool set_sample_rate(uint32_t hz);
+    SampleClock clock;
+
     unsigned long last_resync_millis = 0;
 
     size_t discard_frames(size_t frames_to_discard);
@@ -19,15 +31,28 @@ class Sampler {
     void send_sync_pulse();
     bool sync_indicies();
     size_t read_samples(float* l_buf, float* r_buf, TickType_t timeoutTicks=portMAX_DELAY);
+    size_t read_interleaved(float* frame_buf, size_t frames=FRAMES_PER_READ, TickType_t timeoutTicks=portMAX_DELAY);
+    size_t read_interleaved(q31_t* frame_buf, size_t frames=FRAMES_PER_READ, TickType_t timeoutTicks=portMAX_DELAY);
     size_t read_frames(size_t frames, uint8_t* buf, TickType_t timeoutTicks=portMAX_DELAY);
     void to_voltage(size_t n_frames, uint8_t* input_buf, float* output_l, float* output_r);
+    void to_voltage(size_t n_frames, uint8_t* input_buf, float* output);
     float  sample_to_voltage(int32_t input);
+    void track_noise(size_t n_frames, const uint8_t* input_buf);
+    void prime_correction(size_t n_frames, const uint8_t* input_buf);
 
     FrameCounter frameCounter;
     uint64_t writeIndex = 0;
     uint64_t readIndex = 0;
     uint64_t triggerIndex = 0;
     bool triggered = false;
+
+    // Updated by every decode and discard while noise_tracking is set, cleared while a signal window is read.
+    NoiseFloor noise_floor[CHANNELS];
+    bool noise_tracking = true;
+
+    // Channel gain and delay correction, applied by to_voltage(n, in, out).
+    ChannelCalibration calibration;
+    ChannelCorrector correction;
     const int bclkPin, lrclkPin, dataInPin, sync_pulse_pin;
 
 };
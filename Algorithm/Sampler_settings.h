@@ -2,19 +2,27 @@
 
 #include <Arduino.h>
 #include "driver/i2s.h"
+#include "SampleRate.h"
 //#define SAMPLER_DEBUG // To debug or not to debug
 #define SYNC_DEBUG
 
-#define DMA_BUF_COUNT 30
+// I2S slot width: 32, 24 (packed, 3 bytes per sample) or 16. Narrower slots cost less DMA
+// memory and decode per frame; the decoders (FrameDecode.h) return every width as Q31.
+// The original ESP32 stores 24 bit data in 32 bit words, so 24 buys nothing there and is
+// refused; its 16 bit mode stores each frame as R, L and read_frames() swaps it back.
+#ifndef I2S_SLOT_BITS
+#define I2S_SLOT_BITS 32
+#endif
+
+// DMA memory of the I2S ring. The buffer count follows from the frame size: 30 buffers of
+// 32 bit frames, 40 of 24 bit, 60 of 16 bit. Lower it to save RAM instead of keeping more history.
+#define DMA_RING_BYTES (30 * DMA_BUF_LEN * 8)
 #define DMA_BUF_LEN 128
+#define DMA_BUF_COUNT (DMA_RING_BYTES / (DMA_BUF_LEN * BYTES_PER_FRAME))
 #define FRAMES_PER_READ 128
 #define FRAMES_PER_SIGNAL 10 * FRAMES_PER_READ // 1152 frames
 #define SAFE_FRAME_READ_DIFF 3 * DMA_BUF_LEN
 
-#ifndef SAMPLE_T_US
-#define SAMPLE_T_US 1000.0f / 192.0f
-#endif
-
 #define FLUSH_DMA_BUFFER_THRESHOLD 128
 
 #define SYNC_PULSE_DURATION_US 250 // 48 frames
@@ -25,12 +33,23 @@ const bool SYNC_PULSE_CODE[] = {1, 0, 0, 1, 0, 1, 1, 0, 1, 0}; // {1, 0, 0, 1, 0
 #define SYNC_PULSE_THRESHOLD 0.5
 #define SYNC_SCORE_DIFF_THRESHOLD 5
 #define RESYNC_READINDEX_MS 100
+#define SAMPLE_RATE_SETTLE_MS 10 // discarded after a rate change, converter filters settling
 
 static const i2s_port_t I2S_PORT = I2S_NUM_0;
 
-static const int SAMPLE_RATE = 192000;
+static const int SAMPLE_RATE = SAMPLE_RATE_HZ; // at boot, Sampler::clock holds the current rate
 static const int CHANNELS = 2;
-static const i2s_bits_per_sample_t BITS_PER_SAMPLE = I2S_BITS_PER_SAMPLE_32BIT;
+static const i2s_bits_per_sample_t BITS_PER_SAMPLE = (i2s_bits_per_sample_t)I2S_SLOT_BITS;
 
 static const int BYTES_PER_SAMPLE = (int)BITS_PER_SAMPLE / 8;
 static const int BYTES_PER_FRAME  = CHANNELS * BYTES_PER_SAMPLE;
+
+static_assert(I2S_SLOT_BITS == 32 || I2S_SLOT_BITS == 24 || I2S_SLOT_BITS == 16, "I2S_SLOT_BITS must be 32, 24 or 16");
+#if defined(CONFIG_IDF_TARGET_ESP32) && I2S_SLOT_BITS == 24
+#error "The ESP32 has no packed 24 bit I2S mode, use I2S_SLOT_BITS 32"
+#endif
+#if defined(CONFIG_IDF_TARGET_ESP32) && I2S_SLOT_BITS == 16
+#define I2S_SWAPPED_16BIT_FRAMES
+#endif
+static_assert(DMA_BUF_COUNT >= 2 && DMA_BUF_COUNT <= 128, "DMA_RING_BYTES out of the driver's 2 to 128 buffers");
+static_assert(DMA_BUF_LEN * BYTES_PER_FRAME <= 4092, "DMA buffer larger than one descriptor");
@@ -1,24 +1,58 @@
 #pragma once
 #include <math.h>
 #include <Arduino.h>
+#include "NoiseFloor.h"
+#include "LogRing.h"
+#include "FixedPoint.h"
 
 #define N_PEAKS 20
-#define HANDLE_N_SAMPLES 20
-#define ENERGY_WINDOW 8
+#ifndef ENERGY_WINDOW
+#define ENERGY_WINDOW 8 // host builds may override it, see host/README.md
+#endif
 #define COARSE_STEP 32
 #define K 10
+#define FIXED_THRESHOLD_MIN 1e-3f // V^2, clamp of the threshold for detectors without a reference of their own
+#define FIXED_THRESHOLD_MAX 1e-2f
 #define _EPS 1e-7f // slope tolerance
+#define _EPS_Q31 ((int32_t)(_EPS * (Q31_ONE / Q31_VOLTS) + 0.5f)) // _EPS for Q31 samples
 #define MIN_I_DIFF 4 // min distance between peaks
 #define MAX_I_DIFF 6 // max distance between peaks
 
+// Peak detection state machine, fed one sample difference at a time.
+// Looks for two rises followed by two falls, and stops when the spacing
+// between peaks leaves [min_i_diff, max_i_diff] or max_peaks are found.
+struct PeakTracker {
+    size_t* peaks = nullptr;
+    size_t n_found = 0;
+    bool done = false;
+
+    void reset(size_t* out, size_t max_peaks = N_PEAKS, int min_i_diff = MIN_I_DIFF, int max_i_diff = MAX_I_DIFF);
+    bool step(size_t i, float diff); // false once done
+    bool step(size_t i, int32_t diff); // Q31 samples
+
+    private:
+    bool step_trend(size_t i, int trend); // +1 rise, -1 fall, 0 flat
+
+    int last_peak = -1; // index of last accepted peak
+    bool first = true;
+    int state = 0;
+    int count = 0;
+    size_t max_peaks = N_PEAKS;
+    int min_i_diff = MIN_I_DIFF;
+    int max_i_diff = MAX_I_DIFF;
+};
+
 class SignalAnalyzer {
 public:
-    SignalAnalyzer(float* sample_buffer) : samples(sample_buffer) {}
+    // stride: distance between two samples of this channel, CHANNELS for interleaved frames.
+    SignalAnalyzer(float* sample_buffer, size_t stride = 1) : samples(sample_buffer), stride(stride) {}
 
+    void set_buffer(float* sample_buffer) { samples = sample_buffer; }
     bool analyze(size_t n_samples, size_t& signal_start, size_t* peaks);
-    void handle(size_t n_samples, float* noise_samples);
+    static float noise_threshold(const NoiseFloor& noise);
+    static float fixed_threshold(float noise_threshold);
 
-    float signal_threshold = 0.001f;
+    float signal_threshold = 0.0f; // noise threshold of the window, 0 when none is known
 
 private:
     float sum_square_window(size_t n_samples, size_t index);
@@ -26,4 +60,5 @@ private:
     size_t detect_peaks(size_t n_samples, size_t start_index, size_t* peaks);
 
     float* samples;
+    size_t stride;
 };
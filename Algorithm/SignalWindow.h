@@ -0,0 +1,21 @@
+#pragma once
+#include "SpscQueue.h"
+#include "Sampler_settings.h"
+#include "WindowStorage.h"
+
+// One captured measurement window, interleaved L, R frames.
+struct SignalWindow {
+    WindowFrames frames;         // interleaved frames, float or block floating point (WindowStorage.h)
+    size_t n_frames = 0;
+    uint16_t sig_offset = 0;     // frames between trigger and first captured frame
+    uint64_t trigger_index = 0;  // emission the window is timed against
+    uint64_t first_index = 0;    // read index of frames[0]
+    uint32_t sample_rate = SAMPLE_RATE; // Hz, the capture rate of the frames
+    bool timed = true;           // false when no emission time is known (no distance)
+    float threshold[CHANNELS];   // detection thresholds from the noise floor at capture time
+};
+
+// Two windows passed between the capture task and the analysis task without locks.
+// The capture task reserves, fills and commits a window; the analysis task reads the
+// front window and pops it when done.
+typedef SpscQueue<SignalWindow, 2> WindowHandoff;
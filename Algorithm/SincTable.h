@@ -0,0 +1,171 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Polyphase table of the sinc kernel and its derivative, generated at compile time.
+// Row p holds the kernel for the fractional offset delta = -0.5 + p / SINC_TABLE_PHASES,
+// tap m (0..SINC_TABLE_TAPS-1) is evaluated at u = delta - (m - SINC_TABLE_HALF_TAPS).
+// Values between two rows are found by linear interpolation.
+
+#define SINC_TABLE_HALF_TAPS 5 // Must match INTERPOLATION_NEIGHBOURS.
+#define SINC_TABLE_TAPS (2 * SINC_TABLE_HALF_TAPS + 1)
+#define SINC_TABLE_PHASES 64
+
+struct SincKernelTable {
+    float sinc[SINC_TABLE_PHASES + 1][SINC_TABLE_TAPS];
+    float sinc_der[SINC_TABLE_PHASES + 1][SINC_TABLE_TAPS];
+};
+
+// The same table in Q13 for Q15 samples: the taps of a derivative row sum to less than 4.8
+// in magnitude, so a dot product stays below 2^31.
+#define SINC_TABLE_Q_BITS 13
+
+struct SincKernelTableQ {
+    int16_t sinc[SINC_TABLE_PHASES + 1][SINC_TABLE_TAPS];
+    int16_t sinc_der[SINC_TABLE_PHASES + 1][SINC_TABLE_TAPS];
+};
+
+namespace sinc_table_detail {
+
+constexpr double PI_D = 3.14159265358979323846;
+
+// Taylor series, only used at compile time. |x| is reduced to [-pi, pi] first.
+constexpr double reduce(double x)
+{
+    while (x > PI_D) { x -= 2.0 * PI_D; }
+    while (x < -PI_D) { x += 2.0 * PI_D; }
+    return x;
+}
+
+constexpr double ct_sin(double x)
+{
+    x = reduce(x);
+    double term = x, sum = x;
+    for (int n = 1; n < 20; n++) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double ct_cos(double x)
+{
+    x = reduce(x);
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 20; n++) {
+        term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double ct_abs(double x) { return x < 0.0 ? -x : x; }
+
+constexpr double sinc_pi(double u)
+{
+    if (ct_abs(u) < 1e-9) { return 1.0; }
+    double theta = PI_D * u;
+    return ct_sin(theta) / theta;
+}
+
+constexpr double sinc_pi_der(double u)
+{
+    if (ct_abs(u) < 1e-9) { return 0.0; }
+    double theta = PI_D * u;
+    return (theta * ct_cos(theta) - ct_sin(theta)) / (PI_D * u * u);
+}
+
+constexpr SincKernelTable make_table()
+{
+    SincKernelTable table = {};
+    for (int p = 0; p <= SINC_TABLE_PHASES; p++) {
+        double delta = -0.5 + (double)p / (double)SINC_TABLE_PHASES;
+        for (int m = 0; m < SINC_TABLE_TAPS; m++) {
+            double u = delta - (double)(m - SINC_TABLE_HALF_TAPS);
+            table.sinc[p][m] = (float)sinc_pi(u);
+            table.sinc_der[p][m] = (float)sinc_pi_der(u);
+        }
+    }
+    return table;
+}
+
+constexpr int16_t to_q(double v)
+{
+    double s = v * (double)(1 << SINC_TABLE_Q_BITS);
+    return (int16_t)(s < 0.0 ? s - 0.5 : s + 0.5);
+}
+
+constexpr SincKernelTableQ make_table_q()
+{
+    SincKernelTableQ table = {};
+    for (int p = 0; p <= SINC_TABLE_PHASES; p++) {
+        double delta = -0.5 + (double)p / (double)SINC_TABLE_PHASES;
+        for (int m = 0; m < SINC_TABLE_TAPS; m++) {
+            double u = delta - (double)(m - SINC_TABLE_HALF_TAPS);
+            table.sinc[p][m] = to_q(sinc_pi(u));
+            table.sinc_der[p][m] = to_q(sinc_pi_der(u));
+        }
+    }
+    return table;
+}
+
+} // namespace sinc_table_detail
+
+inline constexpr SincKernelTable SINC_TABLE = sinc_table_detail::make_table();
+inline constexpr SincKernelTableQ SINC_TABLE_Q = sinc_table_detail::make_table_q();
+
+// Finds the two rows surrounding delta and the weight of the upper one.
+static inline void sinc_table_phase(float delta, int& phase, float& frac)
+{
+    float pos = (delta + 0.5f) * (float)SINC_TABLE_PHASES;
+    if (pos < 0.0f) { pos = 0.0f; }
+    phase = (int)pos;
+    if (phase > SINC_TABLE_PHASES - 1) { phase = SINC_TABLE_PHASES - 1; }
+    frac = pos - (float)phase;
+}
+
+// x points to the centre sample, x[-SINC_TABLE_HALF_TAPS .. SINC_TABLE_HALF_TAPS] must be valid.
+static inline float sinc_table_dot(const float (*rows)[SINC_TABLE_TAPS], const float* x, float delta)
+{
+    int phase;
+    float frac;
+    sinc_table_phase(delta, phase, frac);
+
+    const float* k0 = rows[phase];
+    const float* k1 = rows[phase + 1];
+    const float* xm = x - SINC_TABLE_HALF_TAPS;
+
+    float s0 = 0.0f, s1 = 0.0f;
+    for (int m = 0; m < SINC_TABLE_TAPS; m++) {
+        float v = xm[m];
+        s0 += v * k0[m];
+        s1 += v * k1[m];
+    }
+    return s0 + frac * (s1 - s0);
+}
+
+static_assert(SINC_TABLE_PHASES == 64, "sinc_table_dot_q15 assumes 64 phases");
+
+// sinc_table_dot for Q15 samples and delta, Q15 result.
+static inline int32_t sinc_table_dot_q15(const int16_t (*rows)[SINC_TABLE_TAPS], const int32_t* x, int32_t delta)
+{
+    const int PHASE_SHIFT = 15 - 6; // Q15 delta to rows
+
+    int32_t pos = delta + (1 << 14);
+    if (pos < 0) { pos = 0; }
+    int phase = pos >> PHASE_SHIFT;
+    if (phase > SINC_TABLE_PHASES - 1) { phase = SINC_TABLE_PHASES - 1; }
+    int32_t frac = pos - (phase << PHASE_SHIFT); // Q9 weight of the upper row, may reach 2^9 at the end
+
+    const int16_t* k0 = rows[phase];
+    const int16_t* k1 = rows[phase + 1];
+    const int32_t* xm = x - SINC_TABLE_HALF_TAPS;
+
+    int32_t s0 = 0, s1 = 0;
+    for (int m = 0; m < SINC_TABLE_TAPS; m++) {
+        s0 += xm[m] * k0[m];
+        s1 += xm[m] * k1[m];
+    }
+    int64_t s = (int64_t)s0 + ((((int64_t)s1 - s0) * frac) >> PHASE_SHIFT);
+    return (int32_t)(s >> SINC_TABLE_Q_BITS);
+}
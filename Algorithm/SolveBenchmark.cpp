@@ -0,0 +1,149 @@
+#include "SolveBenchmark.h"
+
+#ifdef SOLVE_BENCHMARK
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include "FixedSolver.h"
+#include "SyntheticBurst.h"
+#include "test_data.h"
+
+// CCOUNT per stage of Solver::solve over many runs of the same capture, on the target, so
+// IRAM placement, flash cache misses and interrupts show up as they do in the field.
+// "first" is the warm-up run with cold caches. Every capture is run through Solver on the
+// window storage and through FixedSolver on the same capture in Q31, and the ratio of their
+// mean solve() cycles is printed as q31_speedup (above 1: FixedSolver is faster).
+
+#define SOLVE_BENCH_FRAMES ((TEST_DATA_N > FRAMES_PER_SIGNAL) ? TEST_DATA_N : FRAMES_PER_SIGNAL)
+#define SOLVE_BENCH_STAGES 6
+
+static const char* const STAGE_NAMES[SOLVE_BENCH_STAGES] = { "analyze", "normalize", "interpolate", "correlate", "line_fit", "solve" };
+
+static float bench_frames[CHANNELS * SOLVE_BENCH_FRAMES];
+static WindowFrames bench_window; // bench_frames in the window storage solve() reads
+static q31_t bench_q31[CHANNELS * SOLVE_BENCH_FRAMES];
+static Solver bench_solver;
+static FixedSolver bench_fixed;
+
+static int compare_u32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_stage(const char* solver, const char* capture, const char* stage, uint32_t* cycles, uint32_t first)
+{
+    uint64_t sum = 0;
+    for (size_t r = 0; r < SOLVE_BENCH_RUNS; r++) { sum += cycles[r]; }
+    qsort(cycles, SOLVE_BENCH_RUNS, sizeof(uint32_t), compare_u32);
+
+    Serial.print(solver); Serial.print(",");
+    Serial.print(capture); Serial.print(",");
+    Serial.print(stage); Serial.print(",");
+    Serial.print((unsigned long)cycles[0]); Serial.print(",");
+    Serial.print((float)((double)sum / SOLVE_BENCH_RUNS), 1); Serial.print(",");
+    Serial.print((unsigned long)cycles[(SOLVE_BENCH_RUNS * 99) / 100]); Serial.print(",");
+    Serial.print((unsigned long)cycles[SOLVE_BENCH_RUNS - 1]); Serial.print(",");
+    Serial.println((unsigned long)first);
+}
+
+// solve() only prints when it fails, so a capture that solves in the warm-up run is timed
+// without any Serial output. Returns the mean solve() cycles, 0 when it failed.
+template <class S, class Frames>
+static float bench_solver_on(S& solver, Frames frames, const char* solver_name, const char* name, size_t n_frames, float threshold, uint32_t* cycles)
+{
+    const float thresholds[CHANNELS] = { threshold, threshold };
+    solver.set_thresholds(thresholds);
+
+    float t_diff, sig_delay;
+    Measurement m;
+    uint32_t first[SOLVE_BENCH_STAGES];
+    uint32_t c0 = ESP.getCycleCount();
+    bool ok = solver.solve(frames, n_frames, t_diff, sig_delay, m);
+    first[SOLVE_BENCH_STAGES - 1] = ESP.getCycleCount() - c0;
+    if (!ok) { Serial.print(solver_name); Serial.print(","); Serial.print(name); Serial.println(",failed"); return 0.0f; }
+    first[0] = m.timing.analyze;
+    first[1] = m.timing.normalize;
+    first[2] = m.timing.interpolate;
+    first[3] = m.timing.correlate;
+    first[4] = m.timing.line_fit;
+
+    for (size_t r = 0; r < SOLVE_BENCH_RUNS; r++)
+    {
+        c0 = ESP.getCycleCount();
+        solver.solve(frames, n_frames, t_diff, sig_delay, m);
+        cycles[5 * SOLVE_BENCH_RUNS + r] = ESP.getCycleCount() - c0;
+        cycles[0 * SOLVE_BENCH_RUNS + r] = m.timing.analyze;
+        cycles[1 * SOLVE_BENCH_RUNS + r] = m.timing.normalize;
+        cycles[2 * SOLVE_BENCH_RUNS + r] = m.timing.interpolate;
+        cycles[3 * SOLVE_BENCH_RUNS + r] = m.timing.correlate;
+        cycles[4 * SOLVE_BENCH_RUNS + r] = m.timing.line_fit;
+    }
+
+    uint64_t sum = 0;
+    for (size_t r = 0; r < SOLVE_BENCH_RUNS; r++) { sum += cycles[5 * SOLVE_BENCH_RUNS + r]; }
+    for (int s = 0; s < SOLVE_BENCH_STAGES; s++) { print_stage(solver_name, name, STAGE_NAMES[s], cycles + s * SOLVE_BENCH_RUNS, first[s]); }
+    return (float)((double)sum / SOLVE_BENCH_RUNS);
+}
+
+static void bench_capture(const char* name, size_t n_frames, float threshold, uint32_t* cycles)
+{
+    bench_window.clear();
+    bench_window.append(bench_frames, n_frames);
+    bench_window.finish();
+    n_frames = bench_window.size();
+    for (size_t i = 0; i < CHANNELS * n_frames; i++) { bench_q31[i] = q31_from_volts(bench_frames[i]); }
+
+    float float_cycles = bench_solver_on(bench_solver, bench_window.samples(), "float", name, n_frames, threshold, cycles);
+    float q31_cycles = bench_solver_on(bench_fixed, (const q31_t*)bench_q31, "q31", name, n_frames, threshold, cycles);
+    if (float_cycles > 0.0f && q31_cycles > 0.0f) { Serial.print("q31_speedup,"); Serial.print(name); Serial.print(","); Serial.println(float_cycles / q31_cycles, 3); }
+}
+
+// A burst from 20 degrees with independent noise on both channels.
+static void render_synthetic(float snr_db, float& threshold)
+{
+    static float l[FRAMES_PER_SIGNAL], r[FRAMES_PER_SIGNAL];
+    uint32_t seed = 0x2545f491u;
+    const float lag = SENSOR_DISTANCE_M * sinf(20.0f / RAD_TO_DEG) / SOUND_SPEED * (float)SAMPLE_RATE; // frames
+
+    SyntheticBurst left;
+    left.amplitude = 0.05f;
+    left.rise = 96.0f;
+    left.noise_rms = left.amplitude / sqrtf(2.0f) * powf(10.0f, -snr_db / 20.0f);
+    SyntheticBurst right = left;
+    right.onset += lag;
+    right.phase -= 2.0f * (float)M_PI * right.freq * lag;
+
+    left.render(l, FRAMES_PER_SIGNAL, seed);
+    right.render(r, FRAMES_PER_SIGNAL, seed);
+    for (size_t i = 0; i < FRAMES_PER_SIGNAL; i++) { bench_frames[2 * i] = l[i]; bench_frames[2 * i + 1] = r[i]; }
+
+    NoiseFloor noise;
+    noise.mean = left.noise_rms * left.noise_rms;
+    noise.var = 2.0f * noise.mean * noise.mean;
+    threshold = SignalAnalyzer::noise_threshold(noise);
+}
+
+void run_solve_benchmark()
+{
+    uint32_t* cycles = (uint32_t*)malloc(sizeof(uint32_t) * SOLVE_BENCH_STAGES * SOLVE_BENCH_RUNS);
+    if (!cycles) { Serial.println("Solve benchmark: out of memory"); return; }
+
+    Serial.print("cpu_mhz,"); Serial.println(getCpuFrequencyMhz());
+    Serial.println("solver,capture,stage,min_cycles,mean_cycles,p99_cycles,max_cycles,first_cycles");
+
+    // More captures can be embedded like test_data.h and added here.
+    for (size_t i = 0; i < TEST_DATA_N; i++) { bench_frames[2 * i] = left_test_data[i]; bench_frames[2 * i + 1] = right_test_data[i]; }
+    bench_capture("test_data", TEST_DATA_N, 0.001f, cycles);
+
+    float threshold;
+    render_synthetic(30.0f, threshold);
+    bench_capture("synthetic_30db", FRAMES_PER_SIGNAL, threshold, cycles);
+    render_synthetic(20.0f, threshold);
+    bench_capture("synthetic_20db", FRAMES_PER_SIGNAL, threshold, cycles);
+
+    free(cycles);
+    Serial.flush();
+}
+
+#endif
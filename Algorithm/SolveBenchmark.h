@@ -0,0 +1,9 @@
+#pragma once
+
+//#define SOLVE_BENCHMARK // Time Solver::solve and FixedSolver::solve on embedded captures from setup() instead of measuring.
+
+#define SOLVE_BENCH_RUNS 2000 // timed runs per capture, after one warm-up run
+
+#ifdef SOLVE_BENCHMARK
+void run_solve_benchmark();
+#endif
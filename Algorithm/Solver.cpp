@@ -0,0 +1,378 @@
+#include "Solver.h"
+
+
+bool Solver::solve(WindowSamples frames, size_t n_frames, float& t_diff, float& sig_delay, Measurement& m)
+{
+    PROFILE_SCOPE(PROF_SOLVE);
+    const size_t n_peaks = params.n_peaks;
+    sig = frames;
+    stereo_analyzer.set_buffer(frames);
+    peak_interpolator_l.set_buffer(frames);
+    peak_interpolator_r.set_buffer(frames + 1);
+
+    size_t signal_start_l, est_peaks_l[N_PEAKS];
+    size_t signal_start_r, est_peaks_r[N_PEAKS];
+    {
+        PROFILE_SCOPE_INTO(PROF_ANALYZE, m.timing.analyze);
+        if (!stereo_analyzer.analyze(n_frames, signal_start_l, est_peaks_l, signal_start_r, est_peaks_r)) { LOG(LOG_FAILED_ANALYZER); return false; }
+    }
+
+    {
+        PROFILE_SCOPE_INTO(PROF_NORMALIZE, m.timing.normalize);
+        normalize(n_frames, n_peaks, est_peaks_l, est_peaks_r, stats_l, stats_r);
+        peak_interpolator_l.set_scale(stats_l);
+        peak_interpolator_r.set_scale(stats_r);
+    }
+
+    float peaks_l[N_PEAKS], time_l[N_PEAKS];
+    float peaks_r[N_PEAKS], time_r[N_PEAKS];
+    {
+        PROFILE_SCOPE_INTO(PROF_INTERPOLATE, m.timing.interpolate);
+        if (!peak_interpolator_l.interpolate_peaks<PeakPolicy>(n_frames, n_peaks, est_peaks_l, peaks_l, time_l)) { LOG(LOG_FAILED_INTERP_L); return false; }
+        if (!peak_interpolator_r.interpolate_peaks<PeakPolicy>(n_frames, n_peaks, est_peaks_r, peaks_r, time_r)) { LOG(LOG_FAILED_INTERP_R); return false; }
+    }
+
+    {
+        PROFILE_SCOPE_INTO(PROF_CORRELATE, m.timing.correlate);
+        find_peak_diff(peaks_l, time_l, peaks_r, time_r, t_diff, m.confidence); // Correlate peaks, to find signal diff.
+    }
+
+    {
+        PROFILE_SCOPE_INTO(PROF_LINE_FIT, m.timing.line_fit);
+        find_sig_delay(peaks_l, time_l, peaks_r, time_r, n_peaks, sig_delay);
+    }
+
+    //Serial.print("Signal start left: "); Serial.println(signal_start_l);
+    //Serial.print("Signal start right: "); Serial.println(signal_start_r)
+    
+    //Serial.print("time diff: "); Serial.print(t_diff, 6); Serial.println(" us");
+    //Serial.print("signal delay: "); Serial.print(sig_delay, 6); Serial.println(" us");
+    
+    return true;
+}
+
+
+static inline float corr_norm(const float* a, const float* b, int n)
+{
+    float num = 0.0f, da = 0.0f, db = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        float x = a[i];
+        float y = b[i];
+        num += x * y;
+        da  += x * x;
+        db  += y * y;
+    }
+    float denom = sqrtf(da * db);
+    if (denom < 1e-12f) return -1.0f;
+    return num / denom;
+}
+
+void Solver::find_peak_diff(float* peaks_l, float* time_l,
+                               float* peaks_r, float* time_r,
+                               float& t_diff, float& confidence)
+{
+    const int N = (int)params.n_peaks;
+
+    // Search lag in peak-index domain
+    int L = (int)params.peak_lag;
+    if (L > N - 1) L = N - 1;
+
+    // Fixed overlap length for all lags
+    const int W = N - L;               // same #pairs for each lag
+    const float TIE_EPS = 1e-4f;
+
+    int bestLag = 0;
+    float bestCorr = -2.0f;
+
+    for (int lag = -L; lag <= L; ++lag)
+    {
+        // align: L[i] with R[i+lag]
+        int i0 = (lag < 0) ? -lag : 0;
+        if (i0 + W > N) continue;
+
+        float c = corr_norm(peaks_l + i0, peaks_r + i0 + lag, W);
+
+        if (c > bestCorr + TIE_EPS ||
+            (fabsf(c - bestCorr) <= TIE_EPS && abs(lag) < abs(bestLag)))
+        {
+            bestCorr = c;
+            bestLag = lag;
+        }
+    }
+
+    confidence = fmaxf(0.0f, bestCorr);
+
+    // Now compute delay using median of time differences after shifting by bestLag
+    float dt[N_PEAKS];
+    int n_dt = 0;
+
+    if (bestLag >= 0) {
+        for (int i = 0; i + bestLag < N; ++i) {
+            dt[n_dt++] = time_r[i + bestLag] - time_l[i];  // R - L
+        }
+    } else {
+        int k = -bestLag;
+        for (int i = 0; i + k < N; ++i) {
+            dt[n_dt++] = time_r[i] - time_l[i + k];        // R - L
+        }
+    }
+
+    // sort (small N)
+    for (int i = 0; i < n_dt - 1; ++i) {
+        int mi = i;
+        for (int j = i + 1; j < n_dt; ++j) if (dt[j] < dt[mi]) mi = j;
+        if (mi != i) { float tmp = dt[i]; dt[i] = dt[mi]; dt[mi] = tmp; }
+    }
+
+    if (n_dt <= 0) { t_diff = 0.0f; return; }
+
+    // median
+    if (n_dt & 1) t_diff = dt[n_dt / 2];
+    else          t_diff = 0.5f * (dt[n_dt/2 - 1] + dt[n_dt/2]);
+}
+
+
+
+/*
+void Solver::find_peak_diff(float* peaks_l, float* time_l, float* peaks_r, float* time_r, float& t_diff)
+{
+    const int M = (int)N_PEAKS - 1;
+
+    float dL[N_PEAKS - 1];
+    float dR[N_PEAKS - 1];
+
+    const float DT_EPS = 1e-9f;
+
+    for (int i = 0; i < M; ++i) {
+        float dtL = time_l[i + 1] - time_l[i];
+        float dtR = time_r[i + 1] - time_r[i];
+
+        if (fabsf(dtL) < DT_EPS) dtL = (dtL < 0.0f ? -DT_EPS : DT_EPS);
+        if (fabsf(dtR) < DT_EPS) dtR = (dtR < 0.0f ? -DT_EPS : DT_EPS);
+
+        dL[i] = (peaks_l[i + 1] - peaks_l[i]) / dtL;
+        dR[i] = (peaks_r[i + 1] - peaks_r[i]) / dtR;
+    }
+
+    // Optional, but fine to keep if you already have it.
+    // If normalize_der does abs-max only, the per-lag normalization below still protects you.
+    normalize_der(M, dL);
+    normalize_der(M, dR);
+
+    int bestLag = 0;
+    float bestCorr = -1.0f;
+
+    int L = 10;
+    if (L > M - 1) L = M - 1;
+
+    const int MIN_OVERLAP = 8;
+
+    for (int lag = -L; lag <= L; ++lag) {
+        float num = 0.0f;
+        float denL = 0.0f;
+        float denR = 0.0f;
+        int count = 0;
+
+        for (int i = 0; i < M; ++i) {
+            int j = i + lag;
+            if ((unsigned)j >= (unsigned)M) continue;
+
+            float a = dL[i];
+            float b = dR[j];
+            num  += a * b;
+            denL += a * a;
+            denR += b * b;
+            ++count;
+        }
+
+        if (count < MIN_OVERLAP) continue;
+
+        float denom = sqrtf(denL * denR);
+        if (denom < 1e-12f) continue;
+
+        float corr = num / denom;
+        if (corr > bestCorr) {
+            bestCorr = corr;
+            bestLag = lag;
+        }
+    }
+
+    // Build dt array using the SAME alignment as correlation:
+    // correlation aligns dL[i] with dR[i+lag]
+    // so times align time_l[i] with time_r[i+lag]
+    float dt[N_PEAKS];
+    int n_dt = 0;
+
+    if (bestLag >= 0) {
+        for (int i = 0; i + bestLag < (int)N_PEAKS; ++i) {
+            dt[n_dt++] = time_r[i + bestLag] - time_l[i];   // R - L
+        }
+    } else {
+        int k = -bestLag;
+        for (int i = 0; i + k < (int)N_PEAKS; ++i) {
+            dt[n_dt++] = time_r[i] - time_l[i + k];         // R - L
+        }
+    }
+
+    if (n_dt <= 0) {
+        t_diff = 0.0f;
+        return;
+    }
+
+    // sort dt (small N -> simple sort is fine)
+    for (int i = 0; i < n_dt - 1; ++i) {
+        int min_i = i;
+        for (int j = i + 1; j < n_dt; ++j) {
+            if (dt[j] < dt[min_i]) min_i = j;
+        }
+        if (min_i != i) {
+            float tmp = dt[i];
+            dt[i] = dt[min_i];
+            dt[min_i] = tmp;
+        }
+    }
+
+    // median
+    if (n_dt & 1) {
+        t_diff = dt[n_dt / 2];
+    } else {
+        t_diff = 0.5f * (dt[n_dt / 2 - 1] + dt[n_dt / 2]);
+    }
+}
+*/
+
+
+void Solver::normalize_der(size_t n_der, float* der)
+{
+    if (n_der < 2) return;
+
+    float mean = 0.0f;
+    for (size_t i = 0; i < n_der; ++i) mean += der[i];
+    mean /= (float)n_der;
+
+    float var = 0.0f;
+    for (size_t i = 0; i < n_der; ++i) {
+        float x = der[i] - mean;
+        var += x * x;
+    }
+    var /= (float)(n_der - 1);
+
+    float std = sqrtf(var);
+    if (std < 1e-12f) {
+        for (size_t i = 0; i < n_der; ++i) der[i] = 0.0f;
+        return;
+    }
+
+    float inv = 1.0f / std;
+    for (size_t i = 0; i < n_der; ++i) der[i] = (der[i] - mean) * inv;
+}
+
+void Solver::find_sig_delay(float* peaks_l, float* time_l, float* peaks_r, float* time_r, size_t n_peaks, float& sig_delay)
+{
+    // A degenerate fit (no rise) falls back to the first peak, as in FixedSolver.
+    float a, b;
+    float start_l = time_l[0], start_r = time_r[0];
+    if (fit_line(time_l, peaks_l, (int)n_peaks, a, b)) { start_l = calc_intercept(a, b); }
+    if (fit_line(time_r, peaks_r, (int)n_peaks, a, b)) { start_r = calc_intercept(a, b); }
+
+    //sig_delay = (start_l + start_r) / 2.0f; // mean dist
+    sig_delay = fminf(start_l, start_r); // shortest dist
+}
+
+bool Solver::fit_line(float* t, float* peaks, int n_peaks, float& a, float& b)
+{
+    if (n_peaks < 2) { return false; }
+
+    float T  = 0.0f; // sum t
+    float Y  = 0.0f; // sum y
+    float TT = 0.0f; // sum t^2
+    float TY = 0.0f; // sum t*y
+
+    for (int i = 0; i < n_peaks; ++i) {
+        float ti = t[i];
+        float yi = peaks[i];
+        T  += ti;
+        Y  += yi;
+        TT += ti * ti;
+        TY += ti * yi;
+    }
+
+    float Nf = (float)n_peaks;
+    float D = Nf * TT - T * T;
+
+    float S = Nf * TY - T * Y;
+    if (fabsf(D) < 1e-9f || S == 0.0f) { return false; } // vertical or flat, no good.
+
+    a = S / D;
+    b = (Y - a * T) / Nf;
+    return true;
+}
+
+float Solver::calc_intercept(float a, float b)
+{
+    return -b / a;
+}
+
+float Solver::calc_angle(float t_diff)
+{
+    float theta = t_diff * ANGLE_K;
+    theta = fminf(1.0f, fmaxf(-1.0f, theta));
+    return asinf(theta) * RAD_TO_DEG;
+}
+
+// sig_offset: frames between the emission and the first frame of the window, frame_us long.
+// fixed_delay_us: delays not due to the distance (calibration, correction FIR).
+float Solver::calc_distance(float sig_delay, uint16_t sig_offset, float frame_us, float fixed_delay_us)
+{
+    float sig_delay_offset = (float)sig_offset * frame_us; // us
+    return (sig_delay + sig_delay_offset - fixed_delay_us) * SOUND_SPEED_CM_US; // cm
+}
+
+
+// Running sums for one channel of the normalization region.
+struct RegionAccumulator {
+    float sum = 0.0f;
+    float sum2 = 0.0f;
+    float min = INFINITY;
+    float max = -INFINITY;
+
+    inline void add(float v)
+    {
+        sum += v;
+        sum2 += v * v;
+        if (v < min) { min = v; }
+        if (v > max) { max = v; }
+    }
+
+    void finish(RegionStats& stats) const
+    {
+        size_t n = stats.end - stats.start;
+        if (n == 0) { stats = RegionStats(); return; }
+
+        float n_f = (float)n;
+        stats.dc = sum / n_f;
+        stats.abs_max = fmaxf(max - stats.dc, stats.dc - min);
+        stats.energy = fmaxf(0.0f, sum2 - n_f * stats.dc * stats.dc);
+        stats.gain = (stats.abs_max > 1e-12f) ? 1.0f / stats.abs_max : 1.0f;
+    }
+};
+
+// One pass over both peak regions: DC, abs max (of the DC free signal) and energy.
+// The samples are left untouched, the interpolators apply the scale to the few samples they read.
+void Solver::normalize(size_t n_frames, size_t n_peaks, const size_t* est_peaks_l, const size_t* est_peaks_r, RegionStats& stats_l, RegionStats& stats_r)
+{
+    peak_region(n_frames, n_peaks, est_peaks_l, stats_l);
+    peak_region(n_frames, n_peaks, est_peaks_r, stats_r);
+
+    size_t begin = (stats_l.start < stats_r.start) ? stats_l.start : stats_r.start;
+    size_t end = (stats_l.end > stats_r.end) ? stats_l.end : stats_r.end;
+
+    RegionAccumulator acc_l, acc_r;
+    for (size_t i = begin; i < end; i++) {
+        if (i >= stats_l.start && i < stats_l.end) { acc_l.add(sig[i * CHANNELS]); }
+        if (i >= stats_r.start && i < stats_r.end) { acc_r.add(sig[i * CHANNELS + 1]); }
+    }
+
+    acc_l.finish(stats_l);
+    acc_r.finish(stats_r);
+}
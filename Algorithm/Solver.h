@@ -0,0 +1,76 @@
+#pragma once
+#include "SignalAnalyzer.h"
+#include "StereoAnalyzer.h"
+#include "PeakInterpolator.h"
+#include "Measurement.h"
+#include "Profiler.h"
+#include "WindowStorage.h"
+
+#define SOUND_SPEED 343.0f
+#define SOUND_SPEED_CM_US (SOUND_SPEED * 1e-4f)
+#define CARRIER_HZ 40000.0f // transducer frequency; a peak picked one cycle off moves t_diff by its period
+#define SENSOR_DISTANCE_M 0.1f
+#define MAX_CHANNEL_LAG ((size_t)(SENSOR_DISTANCE_M / SOUND_SPEED * SAMPLE_RATE_HZ) + 2) // frames at the highest rate, bounds every rate
+#define ANGLE_K (SOUND_SPEED / SENSOR_DISTANCE_M) * 1e-6f
+#define RAD_TO_DEG 57.29577951308232f
+#ifndef PEAK_INTERPOLATION_POLICY
+#define PEAK_INTERPOLATION_POLICY SincTablePeak // ParabolicPeak, GaussianPeak, CubicSplinePeak, SincTablePeak, SincExactPeak
+#endif
+
+// The DSP chain from one captured window to t_diff and sig_delay: start and peak
+// detection, normalization, peak interpolation, peak correlation and the envelope line fit.
+// No I/O and no state between windows, so the host tools run the same code, one Solver per thread.
+class Solver {
+    public:
+    Solver()
+    : analyzer_l(nullptr, CHANNELS),
+    analyzer_r(nullptr, CHANNELS),
+    stereo_analyzer(WindowSamples(), analyzer_l, analyzer_r, MAX_CHANNEL_LAG, params),
+    peak_interpolator_l(WindowSamples(), CHANNELS),
+    peak_interpolator_r(WindowSamples(), CHANNELS) {}
+
+    typedef PEAK_INTERPOLATION_POLICY PeakPolicy;
+
+    // Detection thresholds of the window, one per channel (see SignalWindow::threshold).
+    void set_thresholds(const float* thresholds)
+    {
+        analyzer_l.signal_threshold = thresholds[0];
+        analyzer_r.signal_threshold = thresholds[1];
+    }
+
+    // Capture rate of the window (see SignalWindow::sample_rate), for the peak times.
+    void set_sample_rate(uint32_t hz)
+    {
+        float frame_us = SampleClock{ hz }.frame_us();
+        peak_interpolator_l.set_frame_us(frame_us);
+        peak_interpolator_r.set_frame_us(frame_us);
+    }
+
+    // frames: n_frames interleaved L, R frames (SignalWindow::frames.samples(), or a float
+    // array with float windows). t_diff (R - L) and sig_delay in us.
+    bool solve(WindowSamples frames, size_t n_frames, float& t_diff, float& sig_delay, Measurement& m);
+
+    static float calc_angle(float t_diff); // one pair at SENSOR_DISTANCE_M; more microphones: DirectionSolver.h
+    static float calc_distance(float sig_delay, uint16_t sig_offset, float frame_us, float fixed_delay_us);
+
+    RegionStats stats_l, stats_r; // Peak regions of the last solve()
+    AnalysisParams params = TUNED_ANALYSIS_PARAMS; // Must stay valid(), read by every solve()
+
+    private:
+    friend struct SolverStages; // host/bench_stages.cpp times the stages one by one
+
+    void find_peak_diff(float* peaks_l, float* time_l, float* peaks_r, float* time_r, float& t_diff, float& confidence);
+    void find_sig_delay(float* peaks_l, float* time_l, float* peaks_r, float* time_r, size_t n_peaks, float& sig_delay);
+    void normalize(size_t n_frames, size_t n_peaks, const size_t* est_peaks_l, const size_t* est_peaks_r, RegionStats& stats_l, RegionStats& stats_r);
+    void normalize_der(size_t n_der, float* der);
+    bool fit_line(float* t, float* peaks, int n_peaks, float& a, float& b);
+    float calc_intercept(float a, float b);
+
+    WindowSamples sig = WindowSamples(); // Window being analysed, interleaved L, R frames.
+
+    SignalAnalyzer analyzer_l;
+    SignalAnalyzer analyzer_r;
+    BasicStereoAnalyzer<WindowSamples> stereo_analyzer;
+    BasicPeakInterpolator<WindowSamples> peak_interpolator_l;
+    BasicPeakInterpolator<WindowSamples> peak_interpolator_r;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded single-producer/single-consumer ring, lock free.
+// Both sides work on the slots in place: the producer reserves a slot, fills it and
+// commits it; the consumer reads the front slot and pops it when done.
+// N must be a power of two.
+template <class T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+    public:
+    // Producer side. nullptr when the queue is full.
+    T* try_reserve()
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) >= N) { return nullptr; }
+        return &slots[t & (N - 1)];
+    }
+
+    void commit() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    bool push(const T& item)
+    {
+        T* slot = try_reserve();
+        if (!slot) { return false; }
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    // Consumer side. nullptr when the queue is empty.
+    T* front()
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) { return nullptr; }
+        return &slots[h & (N - 1)];
+    }
+
+    void pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+
+    private:
+    T slots[N];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+};
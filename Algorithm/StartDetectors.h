@@ -0,0 +1,183 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "SignalAnalyzer.h"
+#include "FixedPoint.h"
+
+#define CFAR_REF_CELLS 32      // reference samples on each side of the window under test
+#define CFAR_GUARD_CELLS 4     // samples skipped between the window under test and each reference block
+#define CFAR_SCALE 8.0f        // hit when window energy >= CFAR_SCALE * reference energy of one window
+#define CFAR_MIN_ENERGY 1e-8f  // V^2, lowest floor on the window energy so digital silence never triggers
+#define CFAR_RING 128          // power of two, >= CFAR_SPAN + 1
+#define CFAR_LEAD_SPAN (ENERGY_WINDOW + CFAR_GUARD_CELLS + CFAR_REF_CELLS)
+#define CFAR_SPAN (CFAR_LEAD_SPAN + CFAR_GUARD_CELLS + CFAR_REF_CELLS)
+#define NO_INDEX ((size_t)-1)
+
+static_assert(CFAR_RING > CFAR_SPAN && (CFAR_RING & (CFAR_RING - 1)) == 0, "CFAR ring too small or not a power of two");
+
+// Signal start detectors for StereoAnalyzer::analyze<Detector>().
+//
+// Every detector provides:
+//   DELAY  - samples from the first sample of the window under test to the newest sample.
+//   NAME   - label used by the benchmark.
+//   reset  - threshold is the noise floor threshold of the channel (see SignalAnalyzer::noise_threshold).
+//   step   - feeds sample i (i = 0, 1, ...). Once i + 1 >= DELAY, returns whether the
+//            ENERGY_WINDOW samples starting at i + 1 - DELAY are signal.
+
+// Running energy over ENERGY_WINDOW against the clamped noise threshold (SignalAnalyzer::fixed_threshold).
+struct ThresholdStart {
+    static constexpr size_t DELAY = ENERGY_WINDOW;
+    static constexpr const char* NAME = "threshold";
+
+    inline void reset(float threshold)
+    {
+        thres = SignalAnalyzer::fixed_threshold(threshold);
+        energy = 0.0f;
+        for (size_t k = 0; k < ENERGY_WINDOW; k++) { ring[k] = 0.0f; }
+    }
+
+    inline bool step(size_t i, float v)
+    {
+        float v2 = v * v;
+        float& old = ring[i % ENERGY_WINDOW];
+        energy += v2 - old;
+        old = v2;
+        return energy >= thres;
+    }
+
+    float thres = 0.001f;
+    float energy = 0.0f;
+    float ring[ENERGY_WINDOW];
+};
+
+// Cell averaging CFAR. The window under test is compared with the mean energy of
+// CFAR_REF_CELLS lagging (earlier) and leading (later) samples, each behind CFAR_GUARD_CELLS
+// guard samples. The smaller reference is used: at a rising edge the leading cells
+// already hold signal and would mask the onset. Before the lagging cells are complete
+// (start of the capture) only the leading cells are used.
+//
+// The window energy must also reach the noise floor threshold given to reset(), so a burst
+// rising out of a quiet stretch is only taken once it stands above the noise of the channel.
+//
+// Three running sums over a ring of squares, O(1) per sample.
+struct CfarStart {
+    static constexpr size_t DELAY = CFAR_LEAD_SPAN;
+    static constexpr const char* NAME = "cfar";
+
+    inline void reset(float threshold)
+    {
+        min_energy = (threshold > CFAR_MIN_ENERGY) ? threshold : CFAR_MIN_ENERGY;
+        lag = cut = lead = 0.0f;
+        for (size_t k = 0; k < CFAR_RING; k++) { sq[k] = 0.0f; }
+    }
+
+    inline bool step(size_t i, float v)
+    {
+        float v2 = v * v;
+        sq[i & (CFAR_RING - 1)] = v2;
+
+        // Leading cells [i + 1 - CFAR_REF_CELLS, i]
+        lead += v2;
+        if (i >= CFAR_REF_CELLS) { lead -= at(i - CFAR_REF_CELLS); }
+
+        // Window under test [p, p + ENERGY_WINDOW), p = i + 1 - CFAR_LEAD_SPAN
+        const size_t cut_in = CFAR_REF_CELLS + CFAR_GUARD_CELLS;
+        if (i >= cut_in) { cut += at(i - cut_in); }
+        if (i >= cut_in + ENERGY_WINDOW) { cut -= at(i - cut_in - ENERGY_WINDOW); }
+
+        // Lagging cells [p - CFAR_GUARD_CELLS - CFAR_REF_CELLS, p - CFAR_GUARD_CELLS)
+        const size_t lag_in = CFAR_LEAD_SPAN + CFAR_GUARD_CELLS;
+        if (i >= lag_in) { lag += at(i - lag_in); }
+        if (i >= CFAR_SPAN) { lag -= at(i - CFAR_SPAN); }
+
+        float ref = lead;
+        if (i >= CFAR_SPAN - 1 && lag < ref) { ref = lag; }
+
+        float ref_window = ref * ((float)ENERGY_WINDOW / (float)CFAR_REF_CELLS);
+        return cut >= min_energy && cut >= CFAR_SCALE * ref_window;
+    }
+
+    inline float at(size_t i) const { return sq[i & (CFAR_RING - 1)]; }
+
+    float min_energy = CFAR_MIN_ENERGY;
+    float lag = 0.0f, cut = 0.0f, lead = 0.0f;
+    float sq[CFAR_RING];
+};
+
+// Integer detectors for Q31 samples (FixedSolver.h), same decisions as the float ones.
+// Energies are exact int64 sums of Q23 squares (see FixedPoint.h). The rings keep the
+// Q23 samples and square them again on the way out, so they are no larger than the float rings.
+
+static constexpr int64_t CFAR_MIN_ENERGY_Q46 = q46_from_volts2(CFAR_MIN_ENERGY);
+static constexpr int64_t CFAR_SCALE_Q4 = (int64_t)(CFAR_SCALE * 16.0f + 0.5f);
+
+struct ThresholdStartQ31 {
+    static constexpr size_t DELAY = ENERGY_WINDOW;
+    static constexpr const char* NAME = "threshold_q31";
+
+    inline void reset(float threshold)
+    {
+        thres = q46_from_volts2(SignalAnalyzer::fixed_threshold(threshold));
+        energy = 0;
+        for (size_t k = 0; k < ENERGY_WINDOW; k++) { ring[k] = 0; }
+    }
+
+    inline bool step(size_t i, q31_t v)
+    {
+        int32_t& old = ring[i % ENERGY_WINDOW];
+        energy -= (int64_t)old * old;
+        old = v >> 8;
+        energy += (int64_t)old * old;
+        return energy >= thres;
+    }
+
+    int64_t thres = 0;
+    int64_t energy = 0;
+    int32_t ring[ENERGY_WINDOW]; // Q23
+};
+
+struct CfarStartQ31 {
+    static constexpr size_t DELAY = CFAR_LEAD_SPAN;
+    static constexpr const char* NAME = "cfar_q31";
+
+    inline void reset(float threshold)
+    {
+        int64_t thres = q46_from_volts2(threshold);
+        min_energy = (thres > CFAR_MIN_ENERGY_Q46) ? thres : CFAR_MIN_ENERGY_Q46;
+        lag = cut = lead = 0;
+        for (size_t k = 0; k < CFAR_RING; k++) { ring[k] = 0; }
+    }
+
+    inline bool step(size_t i, q31_t v)
+    {
+        int32_t s = v >> 8;
+        ring[i & (CFAR_RING - 1)] = s;
+
+        lead += (int64_t)s * s;
+        if (i >= CFAR_REF_CELLS) { lead -= at(i - CFAR_REF_CELLS); }
+
+        const size_t cut_in = CFAR_REF_CELLS + CFAR_GUARD_CELLS;
+        if (i >= cut_in) { cut += at(i - cut_in); }
+        if (i >= cut_in + ENERGY_WINDOW) { cut -= at(i - cut_in - ENERGY_WINDOW); }
+
+        const size_t lag_in = CFAR_LEAD_SPAN + CFAR_GUARD_CELLS;
+        if (i >= lag_in) { lag += at(i - lag_in); }
+        if (i >= CFAR_SPAN) { lag -= at(i - CFAR_SPAN); }
+
+        int64_t ref = lead;
+        if (i >= CFAR_SPAN - 1 && lag < ref) { ref = lag; }
+
+        // cut >= CFAR_SCALE * ref * ENERGY_WINDOW / CFAR_REF_CELLS, without the division
+        return cut >= min_energy && cut * (16 * CFAR_REF_CELLS) >= CFAR_SCALE_Q4 * ENERGY_WINDOW * ref;
+    }
+
+    inline int64_t at(size_t i) const
+    {
+        int32_t s = ring[i & (CFAR_RING - 1)];
+        return (int64_t)s * s;
+    }
+
+    int64_t min_energy = CFAR_MIN_ENERGY_Q46;
+    int64_t lag = 0, cut = 0, lead = 0;
+    int32_t ring[CFAR_RING]; // Q23
+};
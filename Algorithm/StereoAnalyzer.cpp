@@ -0,0 +1,14 @@
+#include "StereoAnalyzer.h"
+#include "WindowStorage.h"
+
+
+template <class Samples>
+bool BasicStereoAnalyzer<Samples>::analyze(size_t n_frames, size_t& start_l, size_t* peaks_l, size_t& start_r, size_t* peaks_r)
+{
+    return analyze<START_DETECTOR>(n_frames, start_l, peaks_l, start_r, peaks_r);
+}
+
+template class BasicStereoAnalyzer<const float*>;
+#ifdef WINDOW_SAMPLES_VIEW
+template class BasicStereoAnalyzer<WindowSamples>;
+#endif
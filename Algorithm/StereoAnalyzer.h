@@ -0,0 +1,118 @@
+#pragma once
+#include "Sampler_settings.h"
+#include "SignalAnalyzer.h"
+#include "StartDetectors.h"
+#include "AnalysisParams.h"
+
+#define START_DETECTOR CfarStart // ThresholdStart, CfarStart
+#define MIN_HIT_RUN 4 // consecutive right hits before a run counts as an onset
+
+// Differences fed to the peak trackers: volts, or Q31 saturated for FixedSolver.
+static inline float sample_diff(float a, float b) { return a - b; }
+static inline int32_t sample_diff(q31_t a, q31_t b) { return q31_sat((int64_t)a - b); }
+
+// Onset and peak detection for both channels in one pass over interleaved frames.
+//
+// A lead cursor runs the start detectors (see StartDetectors.h), a trailing cursor
+// max_lag + Detector::DELAY frames behind it runs the peak trackers. By the time the
+// trailing cursor reaches a channel's onset, both onsets are known.
+//
+// The left onset is the first window the detector accepts. The right onset must lie within
+// max_lag frames of it (the acoustic delay across SENSOR_DISTANCE_M); hits outside
+// that window are ignored.
+//
+// Samples is the window storage: const float* or a view that indexes the same way
+// (WindowSamples, see WindowStorage.h), or const q31_t* with the Q31 detectors (FixedSolver.h).
+template <class Samples>
+class BasicStereoAnalyzer {
+public:
+    BasicStereoAnalyzer(Samples frame_buffer, const SignalAnalyzer& left, const SignalAnalyzer& right, size_t max_lag, const AnalysisParams& params)
+    : frames(frame_buffer), analyzer_l(left), analyzer_r(right), max_lag(max_lag), params(params) {}
+
+    void set_buffer(Samples frame_buffer) { frames = frame_buffer; }
+    bool analyze(size_t n_frames, size_t& start_l, size_t* peaks_l, size_t& start_r, size_t* peaks_r);
+
+    template <class Detector>
+    bool analyze(size_t n_frames, size_t& start_l, size_t* peaks_l, size_t& start_r, size_t* peaks_r)
+    {
+        const size_t trail = Detector::DELAY + max_lag; // trailing cursor distance
+
+        Detector det_l, det_r;
+        det_l.reset(analyzer_l.signal_threshold);
+        det_r.reset(analyzer_r.signal_threshold);
+
+        // Right runs of hits. CFAR only hits on the rising edge, so a run may be over before
+        // the left onset is found when the right channel leads. The latest run of at least
+        // MIN_HIT_RUN hits is kept (edge_r), shorter runs are noise.
+        size_t run_r = NO_INDEX, run_r_last = NO_INDEX;
+        size_t edge_r = NO_INDEX, edge_r_last = NO_INDEX;
+        start_l = NO_INDEX;
+        start_r = NO_INDEX;
+
+        PeakTracker tracker_l, tracker_r;
+        tracker_l.reset(peaks_l, params.n_peaks, params.min_i_diff, params.max_i_diff);
+        tracker_r.reset(peaks_r, params.n_peaks, params.min_i_diff, params.max_i_diff);
+
+        for (size_t i = 0; i < n_frames + trail; i++)
+        {
+            // Lead cursor: decision for the window starting at p = i + 1 - Detector::DELAY.
+            if (i < n_frames)
+            {
+                bool hit_l = det_l.step(i, frames[i * CHANNELS]);
+                bool hit_r = det_r.step(i, frames[i * CHANNELS + 1]);
+
+                if (i + 1 >= Detector::DELAY)
+                {
+                    size_t p = i + 1 - Detector::DELAY;
+
+                    if (start_l == NO_INDEX && hit_l) { start_l = p; }
+
+                    if (start_r == NO_INDEX)
+                    {
+                        if (hit_r)
+                        {
+                            if (run_r_last == NO_INDEX || run_r_last + 1 != p) { run_r = p; }
+                            run_r_last = p;
+                            if (p + 1 - run_r >= MIN_HIT_RUN) { edge_r = run_r; edge_r_last = p; }
+                        }
+
+                        if (start_l != NO_INDEX)
+                        {
+                            size_t earliest = (start_l > max_lag) ? start_l - max_lag : 0;
+                            if (edge_r != NO_INDEX && edge_r_last >= earliest) { start_r = (edge_r > earliest) ? edge_r : earliest; }
+                            else if (p >= start_l + max_lag) { LOG(LOG_START_NOT_FOUND_R); return false; }
+                        }
+                    }
+                }
+            }
+
+            // Trailing cursor: peak trackers.
+            if (i < trail) { continue; }
+            size_t j = i - trail;
+            if (j == 0 || j >= n_frames) { continue; }
+
+            if (start_l != NO_INDEX && j > start_l && !tracker_l.done) {
+                tracker_l.step(j, sample_diff(frames[j * CHANNELS], frames[(j - 1) * CHANNELS]));
+            }
+            if (start_r != NO_INDEX && j > start_r && !tracker_r.done) {
+                tracker_r.step(j, sample_diff(frames[j * CHANNELS + 1], frames[(j - 1) * CHANNELS + 1]));
+            }
+            if (tracker_l.done && tracker_r.done) { break; }
+            if ((tracker_l.done && tracker_l.n_found < params.n_peaks) || (tracker_r.done && tracker_r.n_found < params.n_peaks)) { break; }
+        }
+
+        if (start_l == NO_INDEX || start_r == NO_INDEX) { LOG(LOG_START_NOT_FOUND); return false; }
+        if (tracker_l.n_found < params.n_peaks || tracker_r.n_found < params.n_peaks) { LOG(LOG_PEAKS_NOT_FOUND); return false; }
+
+        return true;
+    }
+
+private:
+    Samples frames;
+    const SignalAnalyzer& analyzer_l;
+    const SignalAnalyzer& analyzer_r;
+    size_t max_lag;
+    const AnalysisParams& params;
+};
+
+typedef BasicStereoAnalyzer<const float*> StereoAnalyzer;
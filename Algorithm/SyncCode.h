@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+#include "Sampler_settings.h"
+
+// Finds the sync pulse code (SYNC_PULSE_CODE, SYNC_FRAMES_PER_PULSE frames per bit) in the
+// n_samples samples of the channel the pulse is wired to. A bit is 1 where the sample is
+// more than SYNC_PULSE_THRESHOLD below baseline. offset: first frame of the best match,
+// score: its mismatched frames. False when even the best match is off by more than
+// SYNC_SCORE_DIFF_THRESHOLD frames.
+static inline bool find_sync_code(const float* buf, size_t n_samples, float baseline, size_t& offset, unsigned int& score)
+{
+    if (n_samples < SYNC_CODE_TOTAL_LEN) { return false; }
+
+    score = SYNC_CODE_TOTAL_LEN;
+    for (size_t l = 0; l <= n_samples - SYNC_CODE_TOTAL_LEN; l++)
+    {
+        unsigned int s = SYNC_CODE_TOTAL_LEN;
+        for (size_t u = 0; u < SYNC_CODE_TOTAL_LEN; u++)
+        {
+            bool bit_meas = ((buf[l + u] - baseline) < -SYNC_PULSE_THRESHOLD);
+            if (bit_meas == SYNC_PULSE_CODE[u / SYNC_FRAMES_PER_PULSE]) { s--; }
+        }
+        if (s < score) { score = s; offset = l; }
+    }
+    return score <= SYNC_SCORE_DIFF_THRESHOLD;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Deterministic synthetic ultrasonic bursts for the benchmarks.
+// All times are in samples; freq is in cycles per sample.
+struct SyntheticBurst {
+    float freq = 40000.0f / 192000.0f;
+    float onset = 300.0f;
+    float rise = 24.0f;      // samples from onset to full amplitude
+    float length = 240.0f;   // samples from onset to the start of the decay
+    float amplitude = 0.01f; // V
+    float phase = 0.0f;
+    float noise_rms = 0.0f;  // V
+    float dc = 0.0f;         // V
+
+    double envelope(double t) const
+    {
+        double x = t - onset;
+        if (x <= 0.0) { return 0.0; }
+        if (x < rise) { return 0.5 * (1.0 - cos(M_PI * x / rise)); }
+        x -= length;
+        if (x <= 0.0) { return 1.0; }
+        if (x < rise) { return 0.5 * (1.0 + cos(M_PI * x / rise)); }
+        return 0.0;
+    }
+
+    double envelope_der(double t) const
+    {
+        double x = t - onset;
+        if (x <= 0.0) { return 0.0; }
+        if (x < rise) { return 0.5 * M_PI / rise * sin(M_PI * x / rise); }
+        x -= length;
+        if (x <= 0.0 || x >= rise) { return 0.0; }
+        return -0.5 * M_PI / rise * sin(M_PI * x / rise);
+    }
+
+    // Noiseless signal without DC.
+    double value(double t) const
+    {
+        return amplitude * envelope(t) * sin(2.0 * M_PI * freq * t + phase);
+    }
+
+    double derivative(double t) const
+    {
+        double w = 2.0 * M_PI * freq;
+        double arg = w * t + phase;
+        return amplitude * (envelope_der(t) * sin(arg) + envelope(t) * w * cos(arg));
+    }
+
+    // Local maximum of value() within a quarter period of t_guess, bisection on the derivative.
+    double true_peak(double t_guess) const
+    {
+        double q = 0.25 / freq;
+        double lo = t_guess - q, hi = t_guess + q;
+        if (derivative(lo) <= 0.0 || derivative(hi) >= 0.0) { return t_guess; }
+        for (int i = 0; i < 50; i++) {
+            double mid = 0.5 * (lo + hi);
+            if (derivative(mid) > 0.0) { lo = mid; } else { hi = mid; }
+        }
+        return 0.5 * (lo + hi);
+    }
+
+    void render(float* out, size_t n, uint32_t& seed) const
+    {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = (float)(value((double)i) + dc) + noise_rms * gauss(seed);
+        }
+    }
+
+    // xorshift32 + Box-Muller, so captures are identical on host and target.
+    static float uniform(uint32_t& seed)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return ((float)(seed >> 8) + 0.5f) * (1.0f / 16777216.0f);
+    }
+
+    static float gauss(uint32_t& seed)
+    {
+        float u1 = uniform(seed);
+        float u2 = uniform(seed);
+        return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+    }
+};
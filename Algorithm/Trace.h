@@ -0,0 +1,111 @@
+#pragma once
+#include <Arduino.h>
+
+// Begin/end events of tasks and ISRs, timestamped with the cycle counter (CCOUNT) into one
+// ring per core, for seeing how the work of both cores interleaves. trace_dump() prints the
+// rings as text and host/trace_to_chrome turns that into Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev). Header only: Radio/*/Trace.h are symlinks to this file, so the radio
+// sketches trace the same way, and the TRACING line below switches all three sketches.
+//
+// A probe costs an interrupt mask and four stores. Scopes should not block: events are
+// per core, not per task, and a task switch inside a scope shows as nesting.
+//#define TRACING // Without it the probes compile to nothing.
+
+#define TRACE_RING_LEN 1024 // events per core, power of two, the oldest are overwritten
+#define TRACE_CORES 2
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef TRACING
+#include <esp_ipc.h>
+#include <esp_timer.h>
+
+static_assert((TRACE_RING_LEN & (TRACE_RING_LEN - 1)) == 0, "TRACE_RING_LEN must be a power of two");
+
+#define TRACE_INLINE inline __attribute__((always_inline)) // inlined into IRAM ISRs
+
+struct TraceEvent {
+    uint32_t ccount;
+    const char* name; // string literal, only the pointer is stored
+    char phase;       // 'B' begin, 'E' end, 'i' instant
+};
+
+struct TraceRing {
+    TraceEvent events[TRACE_RING_LEN];
+    uint32_t head; // events written, wraps
+};
+
+inline TraceRing trace_rings[TRACE_CORES];
+inline volatile bool trace_enabled = true;
+
+// Masking interrupts makes the ring safe against an ISR on the same core, and every core
+// has its own ring, so no lock is needed.
+static TRACE_INLINE void trace_event(const char* name, char phase)
+{
+    if (!trace_enabled) { return; }
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    TraceRing& ring = trace_rings[xPortGetCoreID()];
+    TraceEvent& e = ring.events[ring.head++ & (TRACE_RING_LEN - 1)];
+    e.ccount = ESP.getCycleCount();
+    e.name = name;
+    e.phase = phase;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+struct TraceScope {
+    TRACE_INLINE TraceScope(const char* name) : name(name) { trace_event(name, 'B'); }
+    TRACE_INLINE ~TraceScope() { trace_event(name, 'E'); }
+    const char* name;
+};
+
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_INSTANT(name) trace_event(name, 'i')
+
+// CCOUNT and esp_timer read together on one core. The counters of the two cores start at
+// different times, so each core's events are placed on the common esp_timer time line by
+// counting back from its own anchor.
+struct TraceAnchor {
+    uint32_t ccount;
+    int64_t time_us;
+};
+
+inline void trace_take_anchor(void* arg)
+{
+    TraceAnchor* anchor = (TraceAnchor*)arg;
+    anchor->ccount = ESP.getCycleCount();
+    anchor->time_us = esp_timer_get_time();
+}
+
+// Prints and clears the rings:
+//   trace,<cpu MHz>
+//   anchor,<core>,<ccount>,<time_us>
+//   ev,<core>,<ccount>,<phase>,<name>    oldest first
+// Tracing pauses while the text is printed.
+static inline void trace_dump()
+{
+    trace_enabled = false;
+    TraceAnchor anchors[TRACE_CORES];
+    for (int c = 0; c < TRACE_CORES; c++) { esp_ipc_call_blocking(c, trace_take_anchor, &anchors[c]); }
+
+    Serial.printf("trace,%u\n", (unsigned)getCpuFrequencyMhz());
+    for (int c = 0; c < TRACE_CORES; c++)
+    {
+        Serial.printf("anchor,%d,%u,%lld\n", c, (unsigned)anchors[c].ccount, (long long)anchors[c].time_us);
+        const TraceRing& ring = trace_rings[c];
+        uint32_t first = (ring.head > TRACE_RING_LEN) ? ring.head - TRACE_RING_LEN : 0;
+        for (uint32_t i = first; i != ring.head; i++)
+        {
+            const TraceEvent& e = ring.events[i & (TRACE_RING_LEN - 1)];
+            Serial.printf("ev,%d,%u,%c,%s\n", c, (unsigned)e.ccount, e.phase, e.name);
+        }
+        trace_rings[c].head = 0;
+    }
+    Serial.println("trace,end");
+    trace_enabled = true;
+}
+
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_INSTANT(name) do {} while (0)
+#endif
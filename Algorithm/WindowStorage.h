@@ -0,0 +1,233 @@
+#pragma once
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "Sampler_settings.h"
+#include "FixedPoint.h"
+
+// Storage of the captured window samples, chosen at compile time.
+//
+// Float windows keep the decoded volts. Block floating point windows keep an integer mantissa
+// per sample and one power of two exponent per channel and BFP_BLOCK frames, picked so the
+// largest sample of the block uses the full mantissa range: int16 halves the window, int8
+// quarters it. The analysis reads either through WindowSamples, which indexes like the
+// interleaved float array (samples[i * CHANNELS + c]), so the kernels run on the stored
+// format without expanding it first.
+//
+// Q31 windows keep the I2S slots for the integer pipeline (FixedSolver.h), which reads them
+// as they are. Through WindowSamples the float stages see volts. The integer pipeline gives
+// the same results as the float one, but is not known to be faster on the target (see
+// FixedSolver.h).
+//
+// The capture side writes through stage() and commit() (decode straight into the window)
+// or append(), then finish() before the window is handed to the analysis.
+//#define BFP_WINDOW_BITS 16 // 16 or 8, float windows without it
+//#define FIXED_POINT_PIPELINE // Q31 windows analysed by FixedSolver instead of Solver
+
+#define BFP_BLOCK 32 // frames per exponent
+
+static_assert((FRAMES_PER_SIGNAL) % BFP_BLOCK == 0, "Windows must hold whole blocks");
+
+class FloatWindowFrames {
+public:
+    typedef float Sample; // what stage() hands out
+
+    void clear() { n = 0; }
+    float* stage(size_t& room) { room = FRAMES_PER_SIGNAL - n; return frames + n * CHANNELS; }
+    void commit(size_t n_frames) { n += n_frames; }
+    void finish() {}
+
+    void append(const float* src, size_t n_frames)
+    {
+        size_t room;
+        float* dst = stage(room);
+        if (n_frames > room) { n_frames = room; }
+        memcpy(dst, src, n_frames * CHANNELS * sizeof(float));
+        commit(n_frames);
+    }
+
+    size_t size() const { return n; }
+    const float* samples() const { return frames; }
+    float at(size_t frame, int c) const { return frames[frame * CHANNELS + c]; }
+
+private:
+    float frames[CHANNELS * FRAMES_PER_SIGNAL];
+    size_t n = 0;
+};
+
+// 2^e for e in [-126, 126], built from the exponent bits.
+static inline float bfp_scale(int e)
+{
+    uint32_t bits = (uint32_t)(e + 127) << 23;
+    float s;
+    memcpy(&s, &bits, sizeof(s));
+    return s;
+}
+
+// Read view of a block floating point window, indexed like the interleaved float array.
+template <class M>
+struct BfpSamples {
+    const M* mantissa = nullptr;
+    const int8_t* exponent = nullptr; // [block * CHANNELS + channel]
+    size_t offset = 0;                // interleaved samples skipped, see operator+
+
+    BfpSamples() {}
+    BfpSamples(decltype(nullptr)) {}
+    BfpSamples(const M* mantissa, const int8_t* exponent, size_t offset = 0) : mantissa(mantissa), exponent(exponent), offset(offset) {}
+
+    inline float operator[](size_t i) const
+    {
+        size_t k = i + offset;
+        size_t block = k / (CHANNELS * BFP_BLOCK);
+        return (float)mantissa[k] * bfp_scale(exponent[block * CHANNELS + k % CHANNELS]);
+    }
+
+    BfpSamples operator+(size_t n) const { return BfpSamples(mantissa, exponent, offset + n); }
+};
+
+template <class M>
+class BfpWindowFrames {
+public:
+    typedef float Sample;
+    static constexpr int MANTISSA_MAX = (1 << (8 * sizeof(M) - 1)) - 1;
+
+    void clear() { n = 0; staged = 0; }
+
+    float* stage(size_t& room)
+    {
+        room = BFP_BLOCK - staged;
+        if (room > FRAMES_PER_SIGNAL - n - staged) { room = FRAMES_PER_SIGNAL - n - staged; }
+        return block + staged * CHANNELS;
+    }
+
+    void commit(size_t n_frames)
+    {
+        staged += n_frames;
+        if (staged == BFP_BLOCK) { encode_block(); }
+    }
+
+    // Encodes a last, partial block.
+    void finish()
+    {
+        if (staged) { encode_block(); }
+    }
+
+    void append(const float* src, size_t n_frames)
+    {
+        while (n_frames)
+        {
+            size_t room;
+            float* dst = stage(room);
+            if (room == 0) { return; }
+            size_t k = (n_frames < room) ? n_frames : room;
+            memcpy(dst, src, k * CHANNELS * sizeof(float));
+            commit(k);
+            src += k * CHANNELS;
+            n_frames -= k;
+        }
+    }
+
+    size_t size() const { return n + staged; }
+    BfpSamples<M> samples() const { return BfpSamples<M>(mantissa, exponent); }
+    float at(size_t frame, int c) const { return samples()[frame * CHANNELS + c]; }
+
+private:
+    void encode_block()
+    {
+        size_t b = n / BFP_BLOCK;
+        for (int c = 0; c < CHANNELS; c++)
+        {
+            float max = 0.0f;
+            for (size_t j = 0; j < staged; j++) { max = fmaxf(max, fabsf(block[j * CHANNELS + c])); }
+
+            int e = -126;
+            if (max > 0.0f)
+            {
+                frexpf(max, &e);         // max = m * 2^e, 0.5 <= m < 1
+                e -= 8 * sizeof(M) - 1;  // so max / 2^e < 2^(bits - 1)
+                if (e < -126) { e = -126; }
+                if (e > 126) { e = 126; }
+            }
+            exponent[b * CHANNELS + c] = (int8_t)e;
+
+            float inv = bfp_scale(-e);
+            for (size_t j = 0; j < staged; j++)
+            {
+                long m = lrintf(block[j * CHANNELS + c] * inv);
+                if (m > MANTISSA_MAX) { m = MANTISSA_MAX; }
+                if (m < -MANTISSA_MAX) { m = -MANTISSA_MAX; }
+                mantissa[(n + j) * CHANNELS + c] = (M)m;
+            }
+        }
+        n += staged;
+        staged = 0;
+    }
+
+    M mantissa[CHANNELS * FRAMES_PER_SIGNAL];
+    int8_t exponent[CHANNELS * FRAMES_PER_SIGNAL / BFP_BLOCK];
+    float block[CHANNELS * BFP_BLOCK]; // frames of the block being filled
+    size_t n = 0;                      // frames encoded
+    size_t staged = 0;                 // frames in block
+};
+
+// Read view of a Q31 window in volts, for the float stages.
+struct Q31Samples {
+    const q31_t* q31 = nullptr;
+
+    Q31Samples() {}
+    Q31Samples(decltype(nullptr)) {}
+    explicit Q31Samples(const q31_t* q31) : q31(q31) {}
+
+    inline float operator[](size_t i) const { return q31_to_volts(q31[i]); }
+    Q31Samples operator+(size_t n) const { return Q31Samples(q31 + n); }
+};
+
+class Q31WindowFrames {
+public:
+    typedef q31_t Sample;
+
+    void clear() { n = 0; }
+    q31_t* stage(size_t& room) { room = FRAMES_PER_SIGNAL - n; return frames + n * CHANNELS; }
+    void commit(size_t n_frames) { n += n_frames; }
+    void finish() {}
+
+    void append(const float* src, size_t n_frames)
+    {
+        size_t room;
+        q31_t* dst = stage(room);
+        if (n_frames > room) { n_frames = room; }
+        for (size_t i = 0; i < n_frames * CHANNELS; i++) { dst[i] = q31_from_volts(src[i]); }
+        commit(n_frames);
+    }
+
+    size_t size() const { return n; }
+    Q31Samples samples() const { return Q31Samples(frames); }
+    float at(size_t frame, int c) const { return q31_to_volts(frames[frame * CHANNELS + c]); }
+
+private:
+    q31_t frames[CHANNELS * FRAMES_PER_SIGNAL];
+    size_t n = 0;
+};
+
+// WINDOW_SAMPLES_VIEW: WindowSamples is a view type, not const float*.
+#if defined(FIXED_POINT_PIPELINE) && defined(BFP_WINDOW_BITS)
+#error "FIXED_POINT_PIPELINE keeps Q31 windows, drop BFP_WINDOW_BITS"
+#elif defined(FIXED_POINT_PIPELINE)
+typedef Q31WindowFrames WindowFrames;
+typedef Q31Samples WindowSamples;
+#define WINDOW_SAMPLES_VIEW
+#elif !defined(BFP_WINDOW_BITS)
+typedef FloatWindowFrames WindowFrames;
+typedef const float* WindowSamples;
+#elif BFP_WINDOW_BITS == 16
+typedef BfpWindowFrames<int16_t> WindowFrames;
+typedef BfpSamples<int16_t> WindowSamples;
+#define WINDOW_SAMPLES_VIEW
+#elif BFP_WINDOW_BITS == 8
+typedef BfpWindowFrames<int8_t> WindowFrames;
+typedef BfpSamples<int8_t> WindowSamples;
+#define WINDOW_SAMPLES_VIEW
+#else
+#error "BFP_WINDOW_BITS must be 16 or 8"
+#endif
@@ -1,11 +1,33 @@
 #include <Arduino.h>
 #include "Algorithm.h"
+#include "InterpolatorBenchmark.h"
+#include "DetectorBenchmark.h"
+#include "SolveBenchmark.h"
+#include "RateBenchmark.h"
+#include "QuadCapture.h"
+#include "MemoryReport.h"
+#include "Profiler.h"
+#include "LogRing.h"
+#include "Trace.h"
 
+#define DUAL_CORE_PIPELINE // Capture on core 0, analysis on core 1.
+//#define FREE_RUNNING_MODE // Open windows on detected bursts, the trigger pin only anchors the transmit schedule.
+//#define CAPTURE_EXPORT // Stream every window to host/capture_receiver at CAPTURE_EXPORT_BAUD, see CaptureExport.h.
+#define RATE_REPORT_MS 5000
+#define MEMORY_REPORT_MS 30000 // Arena, stack high-water marks and heap; 0 disables
+#define LOOP_POLL_MS 100 // Dual core loop() wake-up, for the reports and Serial commands
+#define CAPTURE_TASK_STACK 4096  // bytes, shrink against the memory report
+#define ANALYSIS_TASK_STACK 4096 // bytes
+#define LOG_TASK_PRIORITY 1 // below the capture task, which shares core 0
+//#define RUN_CALIBRATION // Measure channel gain and delay from bursts sent straight ahead, and store them.
+#define CALIBRATION_BURSTS 20
+#define CALIBRATION_DISTANCE_CM 100.0f
 
 // I2S pins for PCM1809
 static const gpio_num_t PIN_BCLK   = GPIO_NUM_26;   // BCK
 static const gpio_num_t PIN_LRCLK  = GPIO_NUM_25;   // LRCLK
 static const gpio_num_t PIN_DATAIN = GPIO_NUM_33;   // DATA
+static const gpio_num_t PIN_DATAIN_B = GPIO_NUM_32; // DATA of the second PCM1809, QUAD_CAPTURE only
 
 // Transistor pulse pin
 static const gpio_num_t PIN_SYNC_PULSE = GPIO_NUM_17;
@@ -15,18 +37,75 @@ static const int TRIGGER_PIN = 18;
 
 Algorithm algorithm(PIN_BCLK, PIN_LRCLK, PIN_DATAIN, PIN_SYNC_PULSE);
 
+#ifdef DUAL_CORE_PIPELINE
+TaskHandle_t captureTaskHandle  = NULL;
+TaskHandle_t analysisTaskHandle = NULL;
+
+void captureTask(void* pvParameters);
+void analysisTask(void* pvParameters);
+#endif
+
 void IRAM_ATTR onTriggerISR() {
+    TRACE_SCOPE("trigger_isr");
     algorithm.trigger();
+    #ifdef DUAL_CORE_PIPELINE
+    if (captureTaskHandle) { vTaskNotifyGiveFromISR(captureTaskHandle, NULL); }
+    #endif
+}
+
+// Sustained measurements per second, printed every RATE_REPORT_MS.
+static void count_measurement()
+{
+    static uint32_t measurements = 0;
+    static unsigned long window_start = millis();
+
+    measurements++;
+    unsigned long now = millis();
+    if (now - window_start >= RATE_REPORT_MS)
+    {
+        Serial.print("Measurements/s: "); Serial.print((float)measurements * 1000.0f / (float)(now - window_start), 2);
+        Serial.print(", dropped windows: "); Serial.println(algorithm.dropped_windows);
+        measurements = 0;
+        window_start = now;
+    }
 }
 
 
 void setup() {
+    #ifdef CAPTURE_EXPORT
+    Serial.setTxBufferSize(CAPTURE_TX_BUFFER);
+    Serial.begin(CAPTURE_EXPORT_BAUD);
+    #else
     Serial.begin(115200);
     //Serial.begin(500000);
+    #endif
     delay(500);
 
+    #ifdef INTERPOLATOR_BENCHMARK
+    run_interpolator_benchmark();
+    while (true) { delay(1000); }
+    #endif
+
+    #ifdef DETECTOR_BENCHMARK
+    run_detector_benchmark();
+    while (true) { delay(1000); }
+    #endif
+
+    #ifdef SOLVE_BENCHMARK
+    run_solve_benchmark();
+    while (true) { delay(1000); }
+    #endif
+
+    #ifdef QUAD_CAPTURE
+    run_quad_capture(PIN_BCLK, PIN_LRCLK, PIN_DATAIN, PIN_DATAIN_B, PIN_SYNC_PULSE, TRIGGER_PIN);
+    #endif
+
+    #ifdef ASYNC_LOG
+    TaskHandle_t log_task = log_begin(LOG_TASK_PRIORITY, 0);
+    memory_report_add_task("log", log_task, LOG_TASK_STACK);
+    #endif
+
     pinMode(TRIGGER_PIN, INPUT_PULLDOWN);
-    attachInterrupt(digitalPinToInterrupt(TRIGGER_PIN), onTriggerISR, RISING);
 
     Serial.println();
     Serial.println("=== Sampler Test ===");
@@ -43,6 +122,55 @@ void setup() {
     Serial.println("Algorithm::begin done (ADC settled)");
     delay(1000);
 
+    #ifdef RATE_BENCHMARK
+    run_rate_benchmark(algorithm);
+    while (true) { delay(1000); }
+    #endif
+
+    attachInterrupt(digitalPinToInterrupt(TRIGGER_PIN), onTriggerISR, RISING);
+
+    #ifdef RUN_CALIBRATION
+    if (!algorithm.calibrate(CALIBRATION_BURSTS, CALIBRATION_DISTANCE_CM)) { Serial.println("Calibration FAILED"); }
+    #else
+    if (!algorithm.load_calibration()) { Serial.println("No channel calibration stored"); }
+    #endif
+
+    #ifdef FREE_RUNNING_MODE
+    algorithm.set_free_running(true);
+    #endif
+
+    #ifdef CAPTURE_EXPORT
+    algorithm.set_capture_export(true);
+    #endif
+
+    #ifdef DUAL_CORE_PIPELINE
+    xTaskCreatePinnedToCore(
+        captureTask,           // Task function
+        "Capture Task",        // Task name
+        CAPTURE_TASK_STACK,    // Stack size
+        NULL,                  // Parameters
+        2,                     // Priority
+        &captureTaskHandle,    // Task handle
+        0                      // Core ID
+    );
+
+    xTaskCreatePinnedToCore(
+        analysisTask,          // Task function
+        "Analysis Task",       // Task name
+        ANALYSIS_TASK_STACK,   // Stack size
+        NULL,                  // Parameters
+        1,                     // Priority
+        &analysisTaskHandle,   // Task handle
+        1                      // Core ID
+    );
+
+    memory_report_add_task("capture", captureTaskHandle, CAPTURE_TASK_STACK);
+    memory_report_add_task("analysis", analysisTaskHandle, ANALYSIS_TASK_STACK);
+    #endif
+    memory_report_add_task("loop", xTaskGetCurrentTaskHandle(), getArduinoLoopTaskStackSize());
+
+    #ifndef DUAL_CORE_PIPELINE
+
     float left[FRAMES_PER_READ], right[FRAMES_PER_READ];
     algorithm.discard_frames(1000);
     size_t _samples = algorithm.read_samples(left, right);
@@ -52,16 +180,43 @@ void setup() {
         Serial.println(right[i], 6);
     }
     while(true);
+    #endif
    
 }
 
 void loop()
 {
+    static unsigned long last_report = millis();
+    if (MEMORY_REPORT_MS && millis() - last_report >= MEMORY_REPORT_MS)
+    {
+        print_memory_report();
+        last_report = millis();
+    }
 
-    if (algorithm.get_triggered_state())
+    // Serial commands: 'i' listens at the idle sample rate until the next onset or trigger,
+    // 'f' full sample rate, 'p' prints the stage profile, 'r' clears it, 't' dumps the trace.
+    while (Serial.available())
+    {
+        int c = Serial.read();
+        if (c == 'i') { algorithm.request_sample_rate(IDLE_SAMPLE_RATE_HZ); }
+        else if (c == 'f') { algorithm.request_sample_rate(SAMPLE_RATE); }
+        #ifdef PROFILING
+        if (c == 'p') { print_profile(); }
+        else if (c == 'r') { profile_reset(); }
+        #endif
+        #ifdef TRACING
+        if (c == 't') { trace_dump(); }
+        #endif
+    }
+
+    #ifdef DUAL_CORE_PIPELINE
+    vTaskDelay(pdMS_TO_TICKS(LOOP_POLL_MS));
+    #else
+
+    if (algorithm.get_triggered_state() || algorithm.is_free_running())
     {
         float angle, distance;
-        algorithm.calculate(angle, distance);
+        if (algorithm.calculate(angle, distance)) { count_measurement(); }
         /*
         int count = 0;
         while(!algorithm.sync_indicies())
@@ -73,4 +228,34 @@ void loop()
     }
     
     algorithm.handle();
+    #endif
+}
+
+#ifdef DUAL_CORE_PIPELINE
+// Core 0: owns the I2S reads. Keeps the DMA ring drained and fills a window on every trigger.
+void captureTask(void* pvParameters) {
+    for (;;) {
+        if (algorithm.capture_window()) {
+            xTaskNotifyGive(analysisTaskHandle);
+        }
+        algorithm.handle();
+
+        // Sleep until the trigger ISR wakes us, at most one tick so the DMA ring never fills.
+        if (!algorithm.get_triggered_state()) {
+            ulTaskNotifyTake(pdTRUE, 1);
+        }
+    }
+}
+
+// Core 1: analyses captured windows while the next one is being captured.
+void analysisTask(void* pvParameters) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (algorithm.window_ready()) {
+            float angle, distance;
+            if (algorithm.process_window(angle, distance)) { count_measurement(); }
+        }
+    }
 }
+#endif
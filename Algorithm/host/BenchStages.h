@@ -0,0 +1,128 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Timing, JSON output and baseline comparison for host/bench_stages.cpp.
+//
+// A stage is timed in batches: the batch size is grown until one batch takes at least
+// min_batch_ns, then repeats batches are run and the per-call times of the batches are
+// reduced to min, median and max. Interference from the rest of the machine only ever adds
+// time, so the min is the most repeatable figure and is the one compared with the baseline.
+
+struct StageResult {
+    std::string stage;
+    std::string input;
+    size_t frames = 0;
+    size_t calls = 0;    // per batch
+    double ns_min = 0.0, ns_median = 0.0, ns_max = 0.0; // per call
+};
+
+// CPU time of the calling thread: time the thread spends preempted is not counted.
+static inline double bench_cpu_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+struct StageBench {
+    int repeats = 15;
+    double min_batch_ns = 2e6;
+    std::vector<StageResult> results;
+
+    // fn() runs the stage once and must not be optimized away (return a value, see sink).
+    template <class Fn>
+    void run(const char* stage, const std::string& input, size_t frames, Fn fn)
+    {
+        size_t calls = 1;
+        for (;;)
+        {
+            double t0 = bench_cpu_ns();
+            for (size_t k = 0; k < calls; k++) { sink += fn(); }
+            if (bench_cpu_ns() - t0 >= min_batch_ns || calls >= ((size_t)1 << 30)) { break; }
+            calls *= 2;
+        }
+
+        std::vector<double> per_call;
+        for (int r = 0; r < repeats; r++)
+        {
+            double t0 = bench_cpu_ns();
+            for (size_t k = 0; k < calls; k++) { sink += fn(); }
+            per_call.push_back((bench_cpu_ns() - t0) / (double)calls);
+        }
+        std::sort(per_call.begin(), per_call.end());
+
+        StageResult res;
+        res.stage = stage;
+        res.input = input;
+        res.frames = frames;
+        res.calls = calls;
+        res.ns_min = per_call.front();
+        res.ns_median = per_call[per_call.size() / 2];
+        res.ns_max = per_call.back();
+        results.push_back(res);
+        fprintf(stderr, "%-24s %-14s %10.1f ns\n", stage, input.c_str(), res.ns_min);
+    }
+
+    // One result per line, so the baseline reader needs no JSON parser.
+    bool write_json(const char* path) const
+    {
+        FILE* f = path ? fopen(path, "w") : stdout;
+        if (!f) { perror(path); return false; }
+        fprintf(f, "{\n  \"repeats\": %d,\n  \"min_batch_ns\": %.0f,\n  \"results\": [\n", repeats, min_batch_ns);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const StageResult& r = results[i];
+            fprintf(f, "    {\"stage\": \"%s\", \"input\": \"%s\", \"frames\": %zu, \"calls\": %zu, \"ns_min\": %.1f, \"ns_median\": %.1f, \"ns_max\": %.1f}%s\n",
+                    r.stage.c_str(), r.input.c_str(), r.frames, r.calls, r.ns_min, r.ns_median, r.ns_max,
+                    (i + 1 < results.size()) ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        if (path) { fclose(f); }
+        return true;
+    }
+
+    static bool read_json(const char* path, std::vector<StageResult>& out)
+    {
+        FILE* f = fopen(path, "r");
+        if (!f) { perror(path); return false; }
+        char line[512], stage[128], input[128];
+        while (fgets(line, sizeof(line), f))
+        {
+            StageResult r;
+            if (sscanf(line, " {\"stage\": \"%127[^\"]\", \"input\": \"%127[^\"]\", \"frames\": %zu, \"calls\": %zu, \"ns_min\": %lf, \"ns_median\": %lf, \"ns_max\": %lf",
+                       stage, input, &r.frames, &r.calls, &r.ns_min, &r.ns_median, &r.ns_max) != 7) { continue; }
+            r.stage = stage;
+            r.input = input;
+            out.push_back(r);
+        }
+        fclose(f);
+        return true;
+    }
+
+    // Prints every stage against the baseline, returns the number slower by more than tolerance_pct.
+    int compare(const std::vector<StageResult>& baseline, double tolerance_pct) const
+    {
+        int regressions = 0;
+        printf("%-24s %-14s %12s %12s %8s\n", "stage", "input", "baseline_ns", "min_ns", "change");
+        for (const StageResult& r : results)
+        {
+            const StageResult* b = nullptr;
+            for (const StageResult& c : baseline) { if (c.stage == r.stage && c.input == r.input) { b = &c; } }
+            if (!b) { printf("%-24s %-14s %12s %12.1f %8s\n", r.stage.c_str(), r.input.c_str(), "-", r.ns_min, "new"); continue; }
+
+            double change = 100.0 * (r.ns_min - b->ns_min) / b->ns_min;
+            bool slower = change > tolerance_pct;
+            regressions += slower ? 1 : 0;
+            printf("%-24s %-14s %12.1f %12.1f %+7.1f%%%s\n", r.stage.c_str(), r.input.c_str(), b->ns_min, r.ns_min, change,
+                   slower ? "  REGRESSION" : (change < -tolerance_pct ? "  faster" : ""));
+        }
+        return regressions;
+    }
+
+    volatile double sink = 0.0;
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "CaptureFile.h"
+
+// A set of capture files (see CaptureFile.h), memory mapped read only and indexed as one
+// sequence. Nothing is copied: records are read straight from the page cache.
+class CaptureCorpus {
+public:
+    struct Capture {
+        const CaptureRecord* record;
+        const float* frames; // record->n_frames interleaved frames
+        size_t file;
+        size_t index;        // record within the file
+        uint32_t sample_rate;  // Hz, from the file header
+    };
+
+    ~CaptureCorpus()
+    {
+        for (File& f : files) { munmap((void*)f.base, f.length); }
+    }
+
+    bool add(const char* path)
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) { perror(path); return false; }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CaptureFileHeader)) { fprintf(stderr, "%s: too short\n", path); close(fd); return false; }
+
+        void* base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) { perror(path); return false; }
+        madvise(base, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+        File f = { path, (const uint8_t*)base, (size_t)st.st_size, *(const CaptureFileHeader*)base, 0 };
+        size_t needed = sizeof(CaptureFileHeader) + capture_record_size(f.header) * f.header.n_captures;
+        if (f.header.magic != CAPTURE_MAGIC || f.header.version != CAPTURE_VERSION || f.header.channels != 2 || needed > f.length)
+        {
+            fprintf(stderr, "%s: not a version %d stereo capture file\n", path, CAPTURE_VERSION);
+            munmap(base, f.length);
+            return false;
+        }
+        f.first = total;
+        total += (size_t)f.header.n_captures;
+        files.push_back(f);
+        return true;
+    }
+
+    size_t size() const { return total; }
+    const char* path(size_t file) const { return files[file].path.c_str(); }
+    const CaptureFileHeader& header(size_t file) const { return files[file].header; }
+
+    Capture operator[](size_t i) const
+    {
+        size_t k = std::upper_bound(files.begin(), files.end(), i, [](size_t v, const File& f) { return v < f.first; }) - files.begin() - 1;
+        const File& f = files[k];
+        size_t index = i - f.first;
+        const uint8_t* p = f.base + sizeof(CaptureFileHeader) + index * capture_record_size(f.header);
+        return { (const CaptureRecord*)p, (const float*)(p + sizeof(CaptureRecord)), k, index, f.header.sample_rate };
+    }
+
+private:
+    struct File {
+        std::string path;
+        const uint8_t* base;
+        size_t length;
+        CaptureFileHeader header;
+        size_t first; // corpus index of the first record
+    };
+
+    std::vector<File> files;
+    size_t total = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+// Both I2S ports of the four microphone array, simulated for BasicQuadSampler
+// (../QuadCapture.h) on the host. One timeline, in frames, stands in for the FrameCounter.
+// Each port's stream starts at its own frame before the timeline index begin() reports, as
+// two DMA rings started at different moments do, so sync() has an offset to find.
+#include <math.h>
+#include "QuadCapture.h"
+#include "Solver.h"
+#include "SyntheticBurst.h"
+
+#define SIM_QUAD_START 4096        // timeline index at begin()
+#define SIM_QUAD_MAX_SKEW 200      // frames a port's stream may start before it
+#define SIM_SYNC_PULSE_VOLTS 1.0f  // the pulse transistor pulls the left inputs this far down
+
+class SimQuadSource {
+    public:
+    SyntheticBurst burst;       // onset in timeline frames, as heard at the array origin
+    float direction[3] = { 0.0f, 1.0f, 0.0f }; // unit vector towards the source
+    uint32_t seed = 1;
+
+    bool begin()
+    {
+        now = SIM_QUAD_START;
+        pulse_start = NO_PULSE;
+        for (int p = 0; p < QUAD_PORTS; p++)
+        {
+            skew[p] = (uint64_t)(SIM_QUAD_MAX_SKEW * SyntheticBurst::uniform(seed));
+            next[p] = now - skew[p];
+        }
+        return true;
+    }
+
+    uint64_t write_index() const { return now; }
+
+    void wait_frames(uint32_t n) { now += n; }
+
+    // Blocks, that is lets the timeline run, until the frames exist. The ring keeps the
+    // newest DMA_BUF_COUNT * DMA_BUF_LEN frames, older ones are lost as on the target.
+    size_t read(int port, uint8_t* buf, size_t frames)
+    {
+        const uint64_t ring = (uint64_t)DMA_BUF_COUNT * DMA_BUF_LEN;
+        if (next[port] + frames > now) { now = next[port] + frames; }
+        if (now - next[port] > ring) { next[port] = now - ring; }
+
+        for (size_t j = 0; j < frames; j++)
+        {
+            double t = (double)(next[port] + j);
+            for (int c = 0; c < CHANNELS; c++, buf += BYTES_PER_SAMPLE)
+            {
+                write_slot(buf, q31_from_volts(volts(port * CHANNELS + c, t)));
+            }
+        }
+        next[port] += frames;
+        return frames;
+    }
+
+    void pulse()
+    {
+        pulse_start = now;
+        now += SYNC_CODE_TOTAL_LEN;
+    }
+
+    // Timeline index of the next frame of port p, what BasicQuadSampler::read_index must match.
+    uint64_t stream_index(int p) const { return next[p]; }
+
+    // Frames port p's stream started before the index begin() reported, what sync() measures.
+    uint64_t skew[QUAD_PORTS] = {};
+
+    // Arrival of the burst at microphone ch relative to the origin, frames.
+    float delay(int ch) const
+    {
+        const float* m = QUAD_MIC_POSITIONS[ch];
+        float along = m[0] * direction[0] + m[1] * direction[1] + m[2] * direction[2];
+        return -along / SOUND_SPEED * (float)SAMPLE_RATE;
+    }
+
+    private:
+    float volts(int ch, double t)
+    {
+        float v = (float)burst.value(t - delay(ch)) + burst.noise_rms * SyntheticBurst::gauss(seed);
+        if (ch % CHANNELS == 0 && t >= (double)pulse_start && t < (double)(pulse_start + SYNC_CODE_TOTAL_LEN))
+        {
+            if (SYNC_PULSE_CODE[(size_t)(t - (double)pulse_start) / SYNC_FRAMES_PER_PULSE]) { v -= SIM_SYNC_PULSE_VOLTS; }
+        }
+        return v;
+    }
+
+    uint64_t now = SIM_QUAD_START;
+    uint64_t next[QUAD_PORTS] = {};
+    static constexpr uint64_t NO_PULSE = UINT64_MAX - SYNC_CODE_TOTAL_LEN;
+    uint64_t pulse_start = NO_PULSE;
+};
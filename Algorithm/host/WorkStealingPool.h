@@ -0,0 +1,93 @@
+#pragma once
+#include <stddef.h>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// parallel_for over [0, n) in chunks. Every worker starts with a contiguous share of the
+// chunks and takes them from the front of its own queue, which keeps its reads sequential.
+// A worker whose queue is empty steals from the back of the fullest other queue, so slow
+// captures (failed detections that scan the whole window) do not leave cores idle.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned n_threads)
+    : n_workers(n_threads ? n_threads : 1), queues(n_workers) {}
+
+    unsigned size() const { return n_workers; }
+
+    // fn(begin, end, worker), worker in [0, size()).
+    template <class Fn>
+    void parallel_for(size_t n, size_t chunk, Fn fn)
+    {
+        if (chunk == 0) { chunk = 1; }
+        size_t n_chunks = (n + chunk - 1) / chunk;
+        for (unsigned w = 0; w < n_workers; w++)
+        {
+            size_t first = n_chunks * w / n_workers;
+            size_t last = n_chunks * (w + 1) / n_workers;
+            queues[w].items.clear();
+            for (size_t c = first; c < last; c++) { queues[w].items.push_back(c); }
+        }
+
+        std::vector<std::thread> threads;
+        for (unsigned w = 0; w < n_workers; w++)
+        {
+            threads.emplace_back([&, w]() {
+                size_t c;
+                while (pop(w, c) || steal(w, c))
+                {
+                    size_t begin = c * chunk;
+                    size_t end = (begin + chunk < n) ? begin + chunk : n;
+                    fn(begin, end, w);
+                }
+            });
+        }
+        for (std::thread& t : threads) { t.join(); }
+    }
+
+    size_t steals = 0; // chunks taken from another worker in the last parallel_for
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    bool pop(unsigned w, size_t& c)
+    {
+        std::lock_guard<std::mutex> guard(queues[w].lock);
+        if (queues[w].items.empty()) { return false; }
+        c = queues[w].items.front();
+        queues[w].items.pop_front();
+        return true;
+    }
+
+    bool steal(unsigned w, size_t& c)
+    {
+        for (;;)
+        {
+            unsigned victim = w;
+            size_t most = 0;
+            for (unsigned v = 0; v < n_workers; v++)
+            {
+                if (v == w) { continue; }
+                std::lock_guard<std::mutex> guard(queues[v].lock);
+                if (queues[v].items.size() > most) { most = queues[v].items.size(); victim = v; }
+            }
+            if (victim == w) { return false; }
+
+            std::lock_guard<std::mutex> guard(queues[victim].lock);
+            if (queues[victim].items.empty()) { continue; } // Emptied meanwhile, look again.
+            c = queues[victim].items.back();
+            queues[victim].items.pop_back();
+            std::lock_guard<std::mutex> count(steal_lock);
+            steals++;
+            return true;
+        }
+    }
+
+    unsigned n_workers;
+    std::vector<Queue> queues;
+    std::mutex steal_lock;
+};
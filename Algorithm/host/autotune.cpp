@@ -0,0 +1,279 @@
+// Parameter sweep over a labelled corpus: evaluates every AnalysisParams candidate of a grid
+// (or a random sample of it) in parallel, reports the Pareto front of angle error against
+// host CPU time per measurement and writes the chosen candidate as tuned_params.h.
+//
+//   autotune [-j threads] [-p name=v1,v2,...] [-r n_random] [-s seed] [-f max_failed_pct]
+//            [-b budget_ns] [-d fixed_delay_us] [-o results.csv] [-i prior.csv] [-w tuned_params.h] files...
+//
+// ENERGY_WINDOW and PEAK_INTERPOLATION_POLICY are compile time; build one tuner per value
+// and merge the runs with -i. Build: see README.md.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Solver.h"
+#include "CaptureCorpus.h"
+#include "WorkStealingPool.h"
+
+#ifdef WINDOW_SAMPLES_VIEW
+#error "autotune solves the float frames of the corpus, build it without BFP_WINDOW_BITS and FIXED_POINT_PIPELINE"
+#endif
+
+struct Axis {
+    const char* name;
+    uint8_t AnalysisParams::* field;
+    std::vector<int> values;
+};
+
+struct Candidate {
+    int energy_window = ENERGY_WINDOW;
+    std::string policy = Solver::PeakPolicy::NAME;
+    AnalysisParams params;
+
+    double failed_pct = 0.0;
+    double angle_rms = NAN, angle_p95 = NAN, distance_rms = NAN;
+    double ns = 0.0; // CPU time per solve()
+    bool front = false;
+
+    bool feasible(double max_failed_pct) const { return failed_pct <= max_failed_pct && !isnan(angle_rms); }
+};
+
+static double thread_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Runs one candidate over the whole corpus. CPU time of the calling thread only, so the
+// cost is comparable whatever the other workers do.
+static void evaluate(const CaptureCorpus& corpus, float fixed_delay_us, Candidate& cand)
+{
+    Solver solver;
+    solver.params = cand.params;
+
+    std::vector<float> angle_err;
+    double distance_sum2 = 0.0;
+    size_t n_distance = 0, failed = 0;
+    double ns = 0.0;
+
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        CaptureCorpus::Capture c = corpus[i];
+        float t_diff, sig_delay;
+        Measurement m;
+
+        solver.set_thresholds(c.record->threshold);
+        solver.set_sample_rate(c.sample_rate);
+        double t0 = thread_ns();
+        bool ok = solver.solve(const_cast<float*>(c.frames), c.record->n_frames, t_diff, sig_delay, m);
+        ns += thread_ns() - t0;
+
+        if (!ok) { failed++; continue; }
+        if (!isnan(c.record->ref_angle)) { angle_err.push_back(fabsf(Solver::calc_angle(t_diff) - c.record->ref_angle)); }
+        if (c.record->timed && !isnan(c.record->ref_distance))
+        {
+            double e = Solver::calc_distance(sig_delay, c.record->sig_offset, SampleClock{ c.sample_rate }.frame_us(), fixed_delay_us) - c.record->ref_distance;
+            distance_sum2 += e * e;
+            n_distance++;
+        }
+    }
+
+    cand.failed_pct = 100.0 * (double)failed / (double)corpus.size();
+    cand.ns = ns / (double)corpus.size();
+    if (!angle_err.empty())
+    {
+        std::sort(angle_err.begin(), angle_err.end());
+        double sum2 = 0.0;
+        for (float e : angle_err) { sum2 += (double)e * e; }
+        cand.angle_rms = sqrt(sum2 / (double)angle_err.size());
+        cand.angle_p95 = angle_err[(size_t)(0.95 * (double)(angle_err.size() - 1))];
+    }
+    if (n_distance) { cand.distance_rms = sqrt(distance_sum2 / (double)n_distance); }
+}
+
+static const char* CSV_HEADER = "energy_window,policy,n_peaks,min_i_diff,max_i_diff,peak_lag,failed_pct,angle_rms,angle_p95,distance_rms,ns";
+
+static void write_row(FILE* f, const Candidate& c)
+{
+    fprintf(f, "%d,%s,%d,%d,%d,%d,%.3f,%.5f,%.5f,%.5f,%.1f\n", c.energy_window, c.policy.c_str(),
+            c.params.n_peaks, c.params.min_i_diff, c.params.max_i_diff, c.params.peak_lag,
+            c.failed_pct, c.angle_rms, c.angle_p95, c.distance_rms, c.ns);
+}
+
+// Results of earlier runs, for candidates that differ in compile time settings.
+static bool read_rows(const char* path, std::vector<Candidate>& out)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+    char line[512];
+    if (!fgets(line, sizeof(line), f)) { fclose(f); return true; }
+    while (fgets(line, sizeof(line), f))
+    {
+        Candidate c;
+        char policy[64];
+        int n, lo, hi, lag;
+        if (sscanf(line, "%d,%63[^,],%d,%d,%d,%d,%lf,%lf,%lf,%lf,%lf", &c.energy_window, policy, &n, &lo, &hi, &lag,
+                   &c.failed_pct, &c.angle_rms, &c.angle_p95, &c.distance_rms, &c.ns) != 11) { continue; }
+        c.policy = policy;
+        c.params.n_peaks = (uint8_t)n;
+        c.params.min_i_diff = (uint8_t)lo;
+        c.params.max_i_diff = (uint8_t)hi;
+        c.params.peak_lag = (uint8_t)lag;
+        out.push_back(c);
+    }
+    fclose(f);
+    return true;
+}
+
+// A feasible candidate is on the front when no other is at least as good in both error and cost.
+static void mark_front(std::vector<Candidate>& cands, double max_failed_pct)
+{
+    for (Candidate& a : cands)
+    {
+        a.front = a.feasible(max_failed_pct);
+        for (const Candidate& b : cands)
+        {
+            if (!a.front) { break; }
+            if (&a == &b || !b.feasible(max_failed_pct)) { continue; }
+            if (b.angle_rms <= a.angle_rms && b.ns <= a.ns && (b.angle_rms < a.angle_rms || b.ns < a.ns)) { a.front = false; }
+        }
+    }
+}
+
+static bool write_header(const char* path, const Candidate& c, size_t n_captures)
+{
+    FILE* f = fopen(path, "w");
+    if (!f) { perror(path); return false; }
+    fprintf(f, "#pragma once\n");
+    fprintf(f, "// Written by host/autotune from %zu captures, rerun it rather than editing.\n", n_captures);
+    fprintf(f, "// angle rms %.4f deg, p95 %.4f deg, distance rms %.4f cm, %.2f%% failed, %.0f ns per solve on the host.\n",
+            c.angle_rms, c.angle_p95, c.distance_rms, c.failed_pct, c.ns);
+    fprintf(f, "// Tuned with PEAK_INTERPOLATION_POLICY %s (Solver.h).\n\n", c.policy.c_str());
+    fprintf(f, "static_assert(ENERGY_WINDOW == %d, \"tuned_params.h was tuned with ENERGY_WINDOW %d\");\n\n", c.energy_window, c.energy_window);
+    fprintf(f, "#define TUNED_ANALYSIS_PARAMS AnalysisParams{ %d, %d, %d, %d } // n_peaks, min_i_diff, max_i_diff, peak_lag\n",
+            c.params.n_peaks, c.params.min_i_diff, c.params.max_i_diff, c.params.peak_lag);
+    fclose(f);
+    return true;
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: autotune [-j threads] [-p name=v1,v2,...] [-r n_random] [-s seed] [-f max_failed_pct]\n"
+                    "                [-b budget_ns] [-d fixed_delay_us] [-o results.csv] [-i prior.csv] [-w tuned_params.h] files...\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<Axis> axes = {
+        { "n_peaks",    &AnalysisParams::n_peaks,    { 8, 12, 16, 20 } },
+        { "min_i_diff", &AnalysisParams::min_i_diff, { 3, 4 } },
+        { "max_i_diff", &AnalysisParams::max_i_diff, { 6, 7 } },
+        { "peak_lag",   &AnalysisParams::peak_lag,   { 2, 4, 6, 10 } },
+    };
+
+    unsigned threads = std::thread::hardware_concurrency();
+    size_t n_random = 0;
+    unsigned seed = 1;
+    double max_failed_pct = 5.0, budget_ns = INFINITY;
+    float fixed_delay_us = 0.0f;
+    const char* out_path = nullptr;
+    const char* header_path = nullptr;
+    std::vector<const char*> priors;
+
+    CaptureCorpus corpus;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc) { threads = (unsigned)atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) { n_random = (size_t)atol(argv[++i]); }
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) { seed = (unsigned)atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) { max_failed_pct = atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) { budget_ns = atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc) { fixed_delay_us = (float)atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) { out_path = argv[++i]; }
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) { priors.push_back(argv[++i]); }
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) { header_path = argv[++i]; }
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+        {
+            const char* arg = argv[++i];
+            const char* eq = strchr(arg, '=');
+            Axis* axis = nullptr;
+            for (Axis& a : axes) { if (eq && strlen(a.name) == (size_t)(eq - arg) && !strncmp(a.name, arg, eq - arg)) { axis = &a; } }
+            if (!axis) { fprintf(stderr, "unknown parameter %s\n", arg); usage(); }
+            axis->values.clear();
+            for (const char* v = eq + 1; *v; v++) { axis->values.push_back(atoi(v)); v = strchr(v, ','); if (!v) { break; } }
+        }
+        else if (argv[i][0] == '-') { usage(); }
+        else if (!corpus.add(argv[i])) { return 1; }
+    }
+    if (corpus.size() == 0) { usage(); }
+
+    // Cartesian product of the axes, invalid combinations dropped.
+    std::vector<Candidate> cands;
+    std::vector<size_t> digit(axes.size(), 0);
+    for (bool more = true; more; )
+    {
+        Candidate c;
+        for (size_t a = 0; a < axes.size(); a++) { c.params.*axes[a].field = (uint8_t)axes[a].values[digit[a]]; }
+        if (c.params.valid()) { cands.push_back(c); }
+
+        more = false;
+        for (size_t a = 0; a < axes.size() && !more; a++)
+        {
+            if (++digit[a] < axes[a].values.size()) { more = true; }
+            else { digit[a] = 0; }
+        }
+    }
+    if (n_random && n_random < cands.size())
+    {
+        std::mt19937 rng(seed);
+        std::shuffle(cands.begin(), cands.end(), rng);
+        cands.resize(n_random);
+    }
+    printf("%zu candidates, %zu captures, ENERGY_WINDOW %d, %s\n", cands.size(), corpus.size(), ENERGY_WINDOW, Solver::PeakPolicy::NAME);
+
+    WorkStealingPool pool(threads);
+    pool.parallel_for(cands.size(), 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; i++) { evaluate(corpus, fixed_delay_us, cands[i]); }
+    });
+
+    if (out_path)
+    {
+        FILE* out = fopen(out_path, "w");
+        if (!out) { perror(out_path); return 1; }
+        fprintf(out, "%s\n", CSV_HEADER);
+        for (const Candidate& c : cands) { write_row(out, c); }
+        fclose(out);
+    }
+
+    for (const char* p : priors) { if (!read_rows(p, cands)) { return 1; } }
+
+    mark_front(cands, max_failed_pct);
+    std::sort(cands.begin(), cands.end(), [](const Candidate& a, const Candidate& b) { return a.ns < b.ns; });
+
+    const Candidate* best = nullptr;
+    printf("Pareto front (failed <= %.1f%%):\n%s\n", max_failed_pct, CSV_HEADER);
+    for (const Candidate& c : cands)
+    {
+        if (!c.front) { continue; }
+        write_row(stdout, c);
+        if (c.ns <= budget_ns && (!best || c.angle_rms < best->angle_rms)) { best = &c; }
+    }
+    if (!best) { fprintf(stderr, "no candidate within the failure limit and budget\n"); return 1; }
+
+    printf("chosen:\n");
+    write_row(stdout, *best);
+    if (best->energy_window != ENERGY_WINDOW || best->policy != Solver::PeakPolicy::NAME)
+    {
+        printf("note: chosen with ENERGY_WINDOW %d and %s, change the firmware to match\n", best->energy_window, best->policy.c_str());
+    }
+    if (header_path && !write_header(header_path, *best, corpus.size())) { return 1; }
+    return 0;
+}
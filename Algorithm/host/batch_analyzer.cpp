@@ -0,0 +1,139 @@
+// Offline batch analyzer: runs the firmware's Solver over memory mapped capture files
+// on all cores and reports per-capture results and aggregate errors.
+//
+//   batch_analyzer [-j threads] [-c chunk] [-o results.csv] [-d fixed_delay_us] files...
+//
+// Build: see README.md.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "FixedSolver.h"
+#include "CaptureCorpus.h"
+#include "WorkStealingPool.h"
+
+struct CaptureResult {
+    bool ok = false;
+    float t_diff = NAN, sig_delay = NAN;
+    float angle = NAN, distance = NAN;
+    float confidence = 0.0f;
+};
+
+// Absolute error statistics over the captures that have ground truth.
+struct ErrorStats {
+    std::vector<float> err;
+
+    void add(float measured, float truth)
+    {
+        if (isnan(truth) || isnan(measured)) { return; }
+        err.push_back(fabsf(measured - truth));
+    }
+
+    void print(const char* name, const char* unit)
+    {
+        if (err.empty()) { printf("%-9s no ground truth\n", name); return; }
+        std::sort(err.begin(), err.end());
+        double sum = 0.0, sum2 = 0.0;
+        for (float e : err) { sum += e; sum2 += (double)e * e; }
+        double n = (double)err.size();
+        printf("%-9s n=%zu mean=%.4f rms=%.4f p50=%.4f p95=%.4f max=%.4f %s\n", name, err.size(),
+               sum / n, sqrt(sum2 / n), err[err.size() / 2], err[(size_t)(0.95 * (n - 1))], err.back(), unit);
+    }
+};
+
+static void usage()
+{
+    fprintf(stderr, "usage: batch_analyzer [-j threads] [-c chunk] [-o results.csv] [-d fixed_delay_us] files...\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    size_t chunk = 64;
+    const char* out_path = nullptr;
+    float fixed_delay_us = 0.0f;
+
+    CaptureCorpus corpus;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc) { threads = (unsigned)atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) { chunk = (size_t)atol(argv[++i]); }
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) { out_path = argv[++i]; }
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc) { fixed_delay_us = (float)atof(argv[++i]); }
+        else if (argv[i][0] == '-') { usage(); }
+        else if (!corpus.add(argv[i])) { return 1; }
+    }
+    if (corpus.size() == 0) { usage(); }
+
+    WorkStealingPool pool(threads);
+    std::vector<WindowSolver> solvers(pool.size());
+#ifdef WINDOW_SAMPLES_VIEW
+    std::vector<WindowFrames> windows(pool.size()); // captures stored as on the target
+#endif
+    std::vector<CaptureResult> results(corpus.size());
+
+    auto t0 = std::chrono::steady_clock::now();
+    pool.parallel_for(corpus.size(), chunk, [&](size_t begin, size_t end, unsigned worker) {
+        WindowSolver& solver = solvers[worker];
+        for (size_t i = begin; i < end; i++)
+        {
+            CaptureCorpus::Capture c = corpus[i];
+            CaptureResult& r = results[i];
+            Measurement m;
+
+            solver.set_thresholds(c.record->threshold);
+            solver.set_sample_rate(c.sample_rate);
+#ifdef WINDOW_SAMPLES_VIEW
+            WindowFrames& window = windows[worker];
+            window.clear();
+            window.append(c.frames, c.record->n_frames);
+            window.finish();
+            r.ok = solver.solve(window.samples(), window.size(), r.t_diff, r.sig_delay, m);
+#else
+            // The solver only reads the frames, the mapping is read only.
+            r.ok = solver.solve(c.frames, c.record->n_frames, r.t_diff, r.sig_delay, m);
+#endif
+            if (!r.ok) { continue; }
+            r.confidence = m.confidence;
+            r.angle = Solver::calc_angle(r.t_diff);
+            r.distance = c.record->timed ? Solver::calc_distance(r.sig_delay, c.record->sig_offset, SampleClock{ c.sample_rate }.frame_us(), fixed_delay_us) : NAN;
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    FILE* out = out_path ? fopen(out_path, "w") : nullptr;
+    if (out_path && !out) { perror(out_path); return 1; }
+    if (out) { fprintf(out, "file,index,ok,angle,distance,t_diff,sig_delay,confidence,ref_angle,ref_distance\n"); }
+
+    ErrorStats angle_err, distance_err;
+    size_t failed = 0;
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        CaptureCorpus::Capture c = corpus[i];
+        const CaptureResult& r = results[i];
+        if (!r.ok) { failed++; }
+        else
+        {
+            angle_err.add(r.angle, c.record->ref_angle);
+            distance_err.add(r.distance, c.record->ref_distance);
+        }
+        if (out)
+        {
+            fprintf(out, "%s,%zu,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", corpus.path(c.file), c.index, r.ok ? 1 : 0,
+                    r.angle, r.distance, r.t_diff, r.sig_delay, r.confidence, c.record->ref_angle, c.record->ref_distance);
+        }
+    }
+    if (out) { fclose(out); }
+
+    printf("captures  %zu in %.3f s (%.0f/s), %u threads, %zu chunks stolen\n",
+           corpus.size(), seconds, (double)corpus.size() / seconds, pool.size(), pool.steals);
+    printf("failed    %zu (%.2f%%)\n", failed, 100.0 * (double)failed / (double)corpus.size());
+    angle_err.print("angle", "deg");
+    distance_err.print("distance", "cm");
+    return 0;
+}
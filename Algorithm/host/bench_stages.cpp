@@ -0,0 +1,246 @@
+// Per-stage timing of the analysis chain on the host: the decode, start and peak detection,
+// normalization, the interpolators, peak correlation, the line fit and the whole solve(),
+// on test_data.h and on synthetic captures of several lengths.
+//
+//   bench_stages [-o results.json] [-b baseline.json] [-t tolerance_pct] [-r repeats] [-m min_batch_ms] [-c cpu]
+//
+// Exits with 1 when a stage is slower than the baseline by more than the tolerance.
+// Build: see README.md.
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "Solver.h"
+#include "FrameDecode.h"
+#include "SyntheticBurst.h"
+#include "test_data.h"
+#include "BenchStages.h"
+
+static const size_t SYNTHETIC_FRAMES[] = { 640, 1280, 2560, 5120 };
+
+// Access to the private stages of Solver (see the friend declaration in Solver.h).
+struct SolverStages {
+    static bool analyze(Solver& s, size_t n, size_t& start_l, size_t* peaks_l, size_t& start_r, size_t* peaks_r)
+    {
+        return s.stereo_analyzer.analyze(n, start_l, peaks_l, start_r, peaks_r);
+    }
+    static void normalize(Solver& s, size_t n, const size_t* peaks_l, const size_t* peaks_r, RegionStats& l, RegionStats& r)
+    {
+        s.normalize(n, s.params.n_peaks, peaks_l, peaks_r, l, r);
+    }
+    static void find_peak_diff(Solver& s, float* peaks_l, float* time_l, float* peaks_r, float* time_r, float& t_diff, float& confidence)
+    {
+        s.find_peak_diff(peaks_l, time_l, peaks_r, time_r, t_diff, confidence);
+    }
+    static bool fit_line(Solver& s, float* t, float* peaks, int n, float& a, float& b) { return s.fit_line(t, peaks, n, a, b); }
+    static void set_buffer(Solver& s, WindowSamples frames) { s.sig = frames; s.stereo_analyzer.set_buffer(frames); }
+};
+
+// Inverse of code_to_voltage(), for feeding the decode.
+static void encode_frames(const std::vector<float>& frames, std::vector<uint8_t>& raw)
+{
+    const float VOLTS_TO_CODE = 2147483648.0f / (2.0f * 1.41421356237f);
+    raw.resize(frames.size() * BYTES_PER_SAMPLE);
+    for (size_t i = 0; i < frames.size(); i++) { write_slot(&raw[i * BYTES_PER_SAMPLE], (int32_t)(frames[i] * VOLTS_TO_CODE)); }
+}
+
+template <class Detector>
+static size_t scan_starts(const float* frames, size_t n, float threshold)
+{
+    Detector det_l, det_r;
+    det_l.reset(threshold);
+    det_r.reset(threshold);
+    size_t hits = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        hits += det_l.step(i, frames[i * CHANNELS]) ? 1 : 0;
+        hits += det_r.step(i, frames[i * CHANNELS + 1]) ? 1 : 0;
+    }
+    return hits;
+}
+
+static size_t track_peaks(const float* frames, size_t n, size_t start, int c, const AnalysisParams& p, size_t* peaks)
+{
+    PeakTracker tracker;
+    tracker.reset(peaks, p.n_peaks, p.min_i_diff, p.max_i_diff);
+    for (size_t j = start + 1; j < n; j++)
+    {
+        if (!tracker.step(j, frames[j * CHANNELS + c] - frames[(j - 1) * CHANNELS + c])) { break; }
+    }
+    return tracker.n_found;
+}
+
+static void bench_input(StageBench& bench, const std::string& name, std::vector<float>& frames, float threshold)
+{
+#ifdef WINDOW_SAMPLES_VIEW
+    // Solver reads the window storage of this build (../WindowStorage.h), as on the target,
+    // which holds one window at most.
+    static WindowFrames window;
+    if (frames.size() > CHANNELS * FRAMES_PER_SIGNAL)
+    {
+        fprintf(stderr, "%s: longer than one window, skipped\n", name.c_str());
+        return;
+    }
+    const size_t n = frames.size() / CHANNELS;
+    window.clear();
+    window.append(frames.data(), n);
+    window.finish();
+    const WindowSamples samples = window.samples();
+#else
+    const size_t n = frames.size() / CHANNELS;
+    const WindowSamples samples = frames.data();
+#endif
+    const float thresholds[CHANNELS] = { threshold, threshold };
+    Solver solver;
+    solver.set_thresholds(thresholds);
+    const size_t n_peaks = solver.params.n_peaks;
+
+    float t_diff, sig_delay;
+    Measurement m;
+    if (!solver.solve(samples, n, t_diff, sig_delay, m)) { fprintf(stderr, "%s: solve failed, skipped\n", name.c_str()); return; }
+
+    // Intermediate results of every stage, inputs of the next.
+    size_t start_l, start_r, est_l[N_PEAKS], est_r[N_PEAKS];
+    SolverStages::analyze(solver, n, start_l, est_l, start_r, est_r);
+    RegionStats stats_l, stats_r;
+    SolverStages::normalize(solver, n, est_l, est_r, stats_l, stats_r);
+
+    PeakInterpolator interp_l(frames.data(), CHANNELS), interp_r(frames.data() + 1, CHANNELS);
+    interp_l.set_scale(stats_l);
+    interp_r.set_scale(stats_r);
+    float peaks_l[N_PEAKS], time_l[N_PEAKS], peaks_r[N_PEAKS], time_r[N_PEAKS];
+    interp_l.interpolate_peaks_table(n, n_peaks, est_l, peaks_l, time_l);
+    interp_r.interpolate_peaks_table(n, n_peaks, est_r, peaks_r, time_r);
+
+    std::vector<uint8_t> raw;
+    encode_frames(frames, raw);
+    std::vector<float> decoded(frames.size());
+    ChannelCalibration calibration;
+    calibration.valid = true;
+    ChannelCorrector correction;
+    correction.configure(calibration);
+    NoiseFloor noise[CHANNELS];
+
+    bench.run("to_voltage", name, n, [&]() {
+        decode_frames(n, raw.data(), decoded.data(), correction, noise);
+        return (double)decoded[frames.size() - 1];
+    });
+    bench.run("detect_start.threshold", name, n, [&]() { return (double)scan_starts<ThresholdStart>(frames.data(), n, threshold); });
+    bench.run("detect_start.cfar", name, n, [&]() { return (double)scan_starts<CfarStart>(frames.data(), n, threshold); });
+    bench.run("detect_peaks", name, n, [&]() {
+        size_t p[N_PEAKS];
+        return (double)(track_peaks(frames.data(), n, start_l, 0, solver.params, p) + track_peaks(frames.data(), n, start_r, 1, solver.params, p));
+    });
+    bench.run("analyze", name, n, [&]() {
+        size_t sl, sr, pl[N_PEAKS], pr[N_PEAKS];
+        SolverStages::set_buffer(solver, samples);
+        return (double)SolverStages::analyze(solver, n, sl, pl, sr, pr);
+    });
+    bench.run("normalize", name, n, [&]() {
+        RegionStats l, r;
+        SolverStages::normalize(solver, n, est_l, est_r, l, r);
+        return (double)(l.gain + r.gain);
+    });
+    bench.run("interpolate.parabolic", name, n, [&]() {
+        float p[N_PEAKS], t[N_PEAKS];
+        interp_l.interpolate_peaks_parabolic(n, n_peaks, est_l, p, t);
+        interp_r.interpolate_peaks_parabolic(n, n_peaks, est_r, p, t);
+        return (double)t[0];
+    });
+    bench.run("interpolate.sinc_table", name, n, [&]() {
+        float p[N_PEAKS], t[N_PEAKS];
+        interp_l.interpolate_peaks_table(n, n_peaks, est_l, p, t);
+        interp_r.interpolate_peaks_table(n, n_peaks, est_r, p, t);
+        return (double)t[0];
+    });
+    bench.run("interpolate.sinc_exact", name, n, [&]() {
+        float p[N_PEAKS], t[N_PEAKS];
+        interp_l.interpolate_peaks(n, n_peaks, est_l, p, t);
+        interp_r.interpolate_peaks(n, n_peaks, est_r, p, t);
+        return (double)t[0];
+    });
+    bench.run("find_peak_diff", name, n, [&]() {
+        float td, conf;
+        SolverStages::find_peak_diff(solver, peaks_l, time_l, peaks_r, time_r, td, conf);
+        return (double)td;
+    });
+    bench.run("fit_line", name, n, [&]() {
+        float a = 0.0f, b = 0.0f;
+        SolverStages::fit_line(solver, time_l, peaks_l, (int)n_peaks, a, b);
+        return (double)(a + b);
+    });
+    bench.run("solve", name, n, [&]() {
+        float td, sd;
+        Measurement mm;
+        solver.solve(samples, n, td, sd, mm);
+        return (double)td;
+    });
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: bench_stages [-o results.json] [-b baseline.json] [-t tolerance_pct] [-r repeats] [-m min_batch_ms] [-c cpu]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    const char* out_path = nullptr;
+    const char* baseline_path = nullptr;
+    double tolerance_pct = 10.0;
+    int cpu = 0;
+    StageBench bench;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) { out_path = argv[++i]; }
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) { baseline_path = argv[++i]; }
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) { tolerance_pct = atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) { bench.repeats = atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) { bench.min_batch_ns = atof(argv[++i]) * 1e6; }
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) { cpu = atoi(argv[++i]); }
+        else { usage(); }
+    }
+    if (bench.repeats < 1) { usage(); }
+
+    // One core for the whole run, so migrations do not show up as noise.
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) { perror("sched_setaffinity"); }
+
+    std::vector<float> frames(CHANNELS * TEST_DATA_N);
+    for (size_t i = 0; i < TEST_DATA_N; i++) { frames[2 * i] = left_test_data[i]; frames[2 * i + 1] = right_test_data[i]; }
+    // No noise estimate (0): ThresholdStart clamps it to its floor, CFAR keeps CFAR_MIN_ENERGY.
+    bench_input(bench, "test_data", frames, 0.0f);
+
+    for (size_t n : SYNTHETIC_FRAMES)
+    {
+        uint32_t seed = 12345;
+        SyntheticBurst burst;
+        burst.amplitude = 0.05f;
+        burst.rise = 96.0f;
+        burst.onset = (float)n / 3.0f;
+        burst.noise_rms = burst.amplitude * 0.01f;
+        SyntheticBurst right = burst;
+        right.onset += 3.3f;
+        right.phase -= 2.0f * (float)M_PI * right.freq * 3.3f;
+
+        std::vector<float> l(n), r(n);
+        burst.render(l.data(), n, seed);
+        right.render(r.data(), n, seed);
+        frames.assign(CHANNELS * n, 0.0f);
+        for (size_t i = 0; i < n; i++) { frames[2 * i] = l[i]; frames[2 * i + 1] = r[i]; }
+        bench_input(bench, "synthetic_" + std::to_string(n), frames, 0.0f);
+    }
+
+    if (!bench.write_json(out_path)) { return 1; }
+    if (!baseline_path) { return 0; }
+
+    std::vector<StageResult> baseline;
+    if (!StageBench::read_json(baseline_path, baseline)) { return 1; }
+    int regressions = bench.compare(baseline, tolerance_pct);
+    if (regressions) { printf("%d stage(s) slower than the baseline by more than %.1f%%\n", regressions, tolerance_pct); }
+    return regressions ? 1 : 0;
+}
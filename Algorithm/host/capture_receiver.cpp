@@ -0,0 +1,114 @@
+// Receives the capture export of the firmware (CAPTURE_EXPORT, see ../CaptureExport.h) and
+// writes the windows to a capture file (../CaptureFile.h) for batch_analyzer and autotune.
+// Damaged packets and any text on the line are skipped.
+//
+//   capture_receiver [-o out.cap] [-f frames] [input]
+//
+// Reads stdin when no input is given. For a live port: stty -F /dev/ttyUSB0 921600 raw
+// and pass the device. The file header is rewritten after every window, so the file is
+// valid whenever the receiver is stopped. Build: see README.md.
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "CaptureFile.h"
+#include "CaptureCodec.h"
+#include "Sampler_settings.h"
+
+static void usage()
+{
+    fprintf(stderr, "usage: capture_receiver [-o out.cap] [-f frames] [input]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    const char* out_path = "capture.cap";
+    const char* in_path = nullptr;
+    size_t frames = FRAMES_PER_SIGNAL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) { out_path = argv[++i]; }
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) { frames = (size_t)atol(argv[++i]); }
+        else if (argv[i][0] == '-' || in_path) { usage(); }
+        else { in_path = argv[i]; }
+    }
+    if (frames == 0 || frames > 0xFFFF) { usage(); }
+
+    int fd = in_path ? open(in_path, O_RDONLY) : 0;
+    if (fd < 0) { perror(in_path); return 1; }
+    FILE* out = fopen(out_path, "wb");
+    if (!out) { perror(out_path); return 1; }
+
+    CaptureFileHeader header = {};
+    header.magic = CAPTURE_MAGIC;
+    header.version = CAPTURE_VERSION;
+    header.sample_rate = SAMPLE_RATE;
+    header.channels = CHANNELS;
+    header.frames = (uint32_t)frames;
+    fwrite(&header, sizeof(header), 1, out);
+
+    const size_t frame_max = capture_frame_max(capture_packet_max(frames));
+    std::vector<uint8_t> pending, packet(frame_max);
+    std::vector<float> samples(frames * CAPTURE_MAX_CHANNELS);
+    size_t rejected = 0, lost = 0;
+    bool have_seq = false;
+    uint16_t next_seq = 0;
+
+    uint8_t chunk[4096];
+    ssize_t got;
+    while ((got = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        for (ssize_t i = 0; i < got; i++)
+        {
+            if (chunk[i] != 0)
+            {
+                // Longer than any packet: text or a lost delimiter, wait for the next 0.
+                if (pending.size() <= frame_max) { pending.push_back(chunk[i]); }
+                continue;
+            }
+            if (pending.empty()) { continue; }
+
+            size_t n = (pending.size() <= frame_max) ? cobs_decode(pending.data(), pending.size(), packet.data()) : SIZE_MAX;
+            pending.clear();
+            CapturePacketHeader h;
+            if (n == SIZE_MAX || !capture_packet_decode(packet.data(), n, h, samples.data(), frames) || h.channels != CHANNELS)
+            {
+                rejected++;
+                continue;
+            }
+
+            if (have_seq) { lost += (uint16_t)(h.seq - next_seq); }
+            have_seq = true;
+            next_seq = (uint16_t)(h.seq + 1);
+
+            CaptureRecord rec = {};
+            rec.trigger_index = h.trigger_index;
+            rec.n_frames = h.n_frames;
+            rec.sig_offset = h.sig_offset;
+            rec.timed = h.timed;
+            for (int c = 0; c < CHANNELS; c++) { rec.threshold[c] = h.threshold[c]; }
+            rec.ref_angle = NAN;
+            rec.ref_distance = NAN;
+            std::fill(samples.begin() + (size_t)h.n_frames * CHANNELS, samples.end(), 0.0f);
+
+            fwrite(&rec, sizeof(rec), 1, out);
+            fwrite(samples.data(), sizeof(float), frames * CHANNELS, out);
+            header.n_captures++;
+            fseek(out, 0, SEEK_SET);
+            fwrite(&header, sizeof(header), 1, out);
+            fseek(out, 0, SEEK_END);
+            fflush(out);
+            if (header.n_captures % 100 == 0) { fprintf(stderr, "\rwindows %llu, lost %zu, rejected %zu", (unsigned long long)header.n_captures, lost, rejected); }
+        }
+    }
+
+    fclose(out);
+    fprintf(stderr, "\rwindows %llu, lost %zu, rejected %zu\n", (unsigned long long)header.n_captures, lost, rejected);
+    return 0;
+}
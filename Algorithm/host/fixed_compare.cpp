@@ -0,0 +1,161 @@
+// Runs Solver and FixedSolver (../FixedSolver.h) over capture files and compares them:
+// which captures each one solves, the differences in t_diff, sig_delay, angle and
+// confidence, and the time each takes for the whole corpus. The captures are quantized to
+// Q31 first, as the firmware's Q31 windows hold them.
+//
+//   fixed_compare [-t t_diff_us] [-s sig_delay_us] [-m mismatch_pct] [-r repeats] [-o results.csv] files...
+//
+// Exits with 1 when FixedSolver is outside the tolerances: more than mismatch_pct of the
+// captures solved by only one of the two, or a 99th percentile difference above t_diff_us
+// or sig_delay_us. Build: see README.md.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "FixedSolver.h"
+#include "CaptureCorpus.h"
+
+#ifdef WINDOW_SAMPLES_VIEW
+#error "fixed_compare compares the float and the Q31 path itself, build it without BFP_WINDOW_BITS and FIXED_POINT_PIPELINE"
+#endif
+
+struct Result {
+    bool ok = false;
+    float t_diff = NAN, sig_delay = NAN, confidence = NAN;
+};
+
+// Absolute differences between the two solvers, over the captures both solve.
+struct DiffStats {
+    std::vector<float> diff;
+
+    void add(float a, float b) { diff.push_back(fabsf(a - b)); }
+
+    float p99()
+    {
+        if (diff.empty()) { return 0.0f; }
+        std::sort(diff.begin(), diff.end());
+        return diff[(size_t)(0.99 * (double)(diff.size() - 1))];
+    }
+
+    void print(const char* name, const char* unit)
+    {
+        if (diff.empty()) { printf("%-10s none\n", name); return; }
+        float p = p99();
+        double sum = 0.0;
+        for (float d : diff) { sum += d; }
+        printf("%-10s mean=%.5f p50=%.5f p99=%.5f max=%.5f %s\n", name, sum / (double)diff.size(),
+               diff[diff.size() / 2], p, diff.back(), unit);
+    }
+};
+
+template <class S, class Frames>
+static double solve_all(S& solver, const CaptureCorpus& corpus, Frames frames_of, std::vector<Result>& results)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        CaptureCorpus::Capture c = corpus[i];
+        Result& r = results[i];
+        Measurement m;
+        solver.set_thresholds(c.record->threshold);
+        solver.set_sample_rate(c.sample_rate);
+        r.ok = solver.solve(frames_of(i, c), c.record->n_frames, r.t_diff, r.sig_delay, m);
+        r.confidence = m.confidence;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: fixed_compare [-t t_diff_us] [-s sig_delay_us] [-m mismatch_pct] [-r repeats] [-o results.csv] files...\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    float tol_t_diff = 0.05f;    // us, 1 % of a frame
+    float tol_sig_delay = 0.5f;  // us
+    float tol_mismatch = 0.5f;   // % of the captures
+    int repeats = 5;
+    const char* out_path = nullptr;
+
+    CaptureCorpus corpus;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc) { tol_t_diff = (float)atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) { tol_sig_delay = (float)atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) { tol_mismatch = (float)atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) { repeats = atoi(argv[++i]); }
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) { out_path = argv[++i]; }
+        else if (argv[i][0] == '-') { usage(); }
+        else if (!corpus.add(argv[i])) { return 1; }
+    }
+    if (corpus.size() == 0 || repeats < 1) { usage(); }
+
+    // Every capture in Q31, one after the other.
+    std::vector<size_t> first(corpus.size());
+    std::vector<q31_t> q31;
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        CaptureCorpus::Capture c = corpus[i];
+        if (c.record->n_frames > 0xFFFF) { fprintf(stderr, "capture %zu: more than 65535 frames\n", i); return 1; }
+        first[i] = q31.size();
+        for (size_t k = 0; k < (size_t)c.record->n_frames * CHANNELS; k++) { q31.push_back(q31_from_volts(c.frames[k])); }
+    }
+
+    Solver solver;
+    FixedSolver fixed;
+    std::vector<Result> float_results(corpus.size()), fixed_results(corpus.size());
+    double float_s = INFINITY, fixed_s = INFINITY;
+    for (int r = 0; r < repeats; r++)
+    {
+        float_s = std::min(float_s, solve_all(solver, corpus, [&](size_t, const CaptureCorpus::Capture& c) { return c.frames; }, float_results));
+        fixed_s = std::min(fixed_s, solve_all(fixed, corpus, [&](size_t i, const CaptureCorpus::Capture&) { return (const q31_t*)&q31[first[i]]; }, fixed_results));
+    }
+
+    FILE* out = out_path ? fopen(out_path, "w") : nullptr;
+    if (out_path && !out) { perror(out_path); return 1; }
+    if (out) { fprintf(out, "file,index,float_ok,fixed_ok,float_t_diff,fixed_t_diff,float_sig_delay,fixed_sig_delay,float_confidence,fixed_confidence\n"); }
+
+    DiffStats t_diff, sig_delay, angle, confidence;
+    size_t both = 0, float_only = 0, fixed_only = 0;
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        const Result& a = float_results[i];
+        const Result& b = fixed_results[i];
+        if (a.ok && b.ok)
+        {
+            both++;
+            t_diff.add(a.t_diff, b.t_diff);
+            sig_delay.add(a.sig_delay, b.sig_delay);
+            angle.add(Solver::calc_angle(a.t_diff), Solver::calc_angle(b.t_diff));
+            confidence.add(a.confidence, b.confidence);
+        }
+        else if (a.ok) { float_only++; }
+        else if (b.ok) { fixed_only++; }
+
+        if (out)
+        {
+            CaptureCorpus::Capture c = corpus[i];
+            fprintf(out, "%s,%zu,%d,%d,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f\n", corpus.path(c.file), c.index, a.ok ? 1 : 0, b.ok ? 1 : 0,
+                    a.t_diff, b.t_diff, a.sig_delay, b.sig_delay, a.confidence, b.confidence);
+        }
+    }
+    if (out) { fclose(out); }
+
+    double n = (double)corpus.size();
+    double mismatch = 100.0 * (double)(float_only + fixed_only) / n;
+    printf("captures   %zu, both solved %zu, float only %zu, fixed only %zu (%.2f%%)\n", corpus.size(), both, float_only, fixed_only, mismatch);
+    t_diff.print("t_diff", "us");
+    sig_delay.print("sig_delay", "us");
+    angle.print("angle", "deg");
+    confidence.print("confidence", "");
+    printf("time       float %.2f us, fixed %.2f us per capture, speedup %.2fx (host)\n", 1e6 * float_s / n, 1e6 * fixed_s / n, float_s / fixed_s);
+
+    bool pass = mismatch <= tol_mismatch && t_diff.p99() <= tol_t_diff && sig_delay.p99() <= tol_sig_delay;
+    printf("%s: tolerances mismatch %.2f%%, t_diff p99 %.3f us, sig_delay p99 %.3f us\n", pass ? "PASS" : "FAIL", tol_mismatch, tol_t_diff, tol_sig_delay);
+    return pass ? 0 : 1;
+}
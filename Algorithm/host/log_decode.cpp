@@ -0,0 +1,109 @@
+// Turns the binary LOG() records of the firmware (see ../LogRing.h) back into text. Bytes
+// outside a valid frame, such as plain Serial prints, are passed through unchanged.
+//
+//   log_decode [input]
+//
+// Reads stdin when no input is given. For a live port: stty -F /dev/ttyUSB0 115200 raw
+// and pass the device. Build: see README.md.
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "LogRing.h"
+
+static size_t decoded = 0, rejected = 0;
+
+static uint32_t read_u32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+// printf() of one format from LogFormats.h, taking its arguments from the record words.
+static void print_record(uint32_t time_us, const char* f, const uint32_t* w)
+{
+    printf("[%10u] ", time_us);
+    while (*f)
+    {
+        if (*f != '%') { putchar(*f++); continue; }
+        if (f[1] == '%') { putchar('%'); f += 2; continue; }
+
+        char spec[16];
+        size_t k = 0;
+        spec[k++] = *f++;
+        while (*f && strchr("-0123456789.", *f) && k < 10) { spec[k++] = *f++; }
+        bool wide = (f[0] == 'l' && f[1] == 'l');
+        if (wide) { spec[k++] = 'l'; spec[k++] = 'l'; f += 2; }
+        char conv = *f ? *f++ : 'u';
+        spec[k++] = conv;
+        spec[k] = '\0';
+
+        if (wide) { printf(spec, (unsigned long long)w[0] | ((unsigned long long)w[1] << 32)); w += 2; }
+        else if (conv == 'f')
+        {
+            float v;
+            memcpy(&v, w++, sizeof(v));
+            printf(spec, (double)v);
+        }
+        else if (conv == 'd' || conv == 'i') { printf(spec, (int)(int32_t)*w++); }
+        else { printf(spec, (unsigned)*w++); }
+    }
+    putchar('\n');
+}
+
+// Decodes what it can of p[0, n), returns the bytes consumed. An incomplete frame at the end
+// is left for the next call unless this is the final one.
+static size_t decode(const uint8_t* p, size_t n, bool final)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        if (p[i] != LOG_FRAME_MAGIC) { putchar(p[i++]); continue; }
+        if (n - i < LOG_FRAME_HEADER)
+        {
+            if (!final) { break; }
+            i++; rejected++; continue;
+        }
+
+        uint16_t id = (uint16_t)(p[i + 1] | (p[i + 2] << 8));
+        uint8_t n_words = p[i + 3];
+        if (id >= LOG_COUNT || n_words != log_format_words(LOG_FORMAT_STRINGS[id])) { i++; rejected++; continue; }
+
+        size_t len = LOG_FRAME_HEADER + 4 * (size_t)n_words + 1;
+        if (n - i < len)
+        {
+            if (!final) { break; }
+            i++; rejected++; continue;
+        }
+
+        uint8_t sum = 0;
+        for (size_t k = i + 1; k < i + len - 1; k++) { sum += p[k]; }
+        if (sum != p[i + len - 1]) { i++; rejected++; continue; }
+
+        uint32_t words[LOG_MAX_WORDS];
+        for (uint8_t k = 0; k < n_words; k++) { words[k] = read_u32(p + i + LOG_FRAME_HEADER + 4 * k); }
+        print_record(read_u32(p + i + 4), LOG_FORMAT_STRINGS[id], words);
+        decoded++;
+        i += len;
+    }
+    return i;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 2) { fprintf(stderr, "usage: log_decode [input]\n"); return 2; }
+    int fd = (argc == 2) ? open(argv[1], O_RDONLY) : 0;
+    if (fd < 0) { perror(argv[1]); return 1; }
+
+    // read() returns whatever has arrived, so a live port is decoded as it comes in.
+    std::vector<uint8_t> buf;
+    uint8_t chunk[4096];
+    ssize_t got;
+    while ((got = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        buf.insert(buf.end(), chunk, chunk + got);
+        buf.erase(buf.begin(), buf.begin() + decode(buf.data(), buf.size(), false));
+        fflush(stdout);
+    }
+    decode(buf.data(), buf.size(), true);
+
+    fprintf(stderr, "%zu records decoded, %zu bytes rejected\n", decoded, rejected);
+    return 0;
+}
@@ -0,0 +1,204 @@
+// Runs BasicQuadSampler (../QuadCapture.h) on SimQuadSource: both ports start their streams
+// at different frames, sync() aligns them, and every trial captures one burst from a random
+// direction and solves all six microphone pairs with Solver. The pair time differences are
+// compared with the geometry of QUAD_MIC_POSITIONS, and DirectionSolver (../DirectionSolver.h)
+// turns them into azimuth and elevation, compared with the direction of the trial.
+//
+//   quad_sim [-n trials] [-s snr_db] [-t tolerance_us] [-d direction_deg] [-x failed_pct] [-u] [seed]
+//
+// -u skips sync(), to show what the pairs across the two ports look like without it. Exits
+// with 1 when a sync lands off the true stream index, or when the median error of the pairs
+// across the ports exceeds that of the pairs within a port by more than tolerance_us. That
+// leaves out what Solver itself gets wrong, such as slipping a carrier period (25 us) on a
+// share of the bursts, which happens on both kinds of pairs alike.
+//
+// DirectionSolver takes those slips off (DirectionSolver::slip_us). A trial fails the
+// direction check when it has no direction of rank 3, or one more than direction_deg off;
+// more than failed_pct of such trials (default 5 %) fails the run. At the default 30 dB
+// about 2 % have no direction, mostly because Solver failed every pair of one microphone
+// and the other three are coplanar, and about 1.6 % are off by the few degrees of a slip
+// that fits another direction as well. Build: see README.md.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "SimQuadSource.h"
+#include "DirectionSolver.h"
+
+#ifdef WINDOW_SAMPLES_VIEW
+#error "quad_sim solves float windows as QUAD_CAPTURE does, build it without BFP_WINDOW_BITS and FIXED_POINT_PIPELINE"
+#endif
+
+#define SIM_DRAIN_ROUNDS 20     // drains before each trigger, for the noise floors
+#define SIM_DRAIN_FRAMES 200    // timeline frames between two drains
+#define SIM_ONSET_MIN 300.0f    // frames from the trigger to the burst at the origin
+#define SIM_ONSET_SPAN 200.0f
+#define SIM_MAX_ELEVATION 30.0f // degrees
+
+static const int PAIRS[][2] = { { 0, 1 }, { 2, 3 }, { 0, 2 }, { 0, 3 }, { 1, 2 }, { 1, 3 } };
+static const size_t N_PAIRS = sizeof(PAIRS) / sizeof(PAIRS[0]);
+
+struct PairStats {
+    std::vector<float> err;
+    size_t failed = 0;
+
+    float percentile(double q)
+    {
+        if (err.empty()) { return INFINITY; }
+        std::sort(err.begin(), err.end());
+        return err[(size_t)(q * (double)(err.size() - 1))];
+    }
+
+    void print(const char* name, const char* unit = "us")
+    {
+        if (err.empty()) { printf("%-6s all %zu failed\n", name, failed); return; }
+        std::sort(err.begin(), err.end());
+        double sum = 0.0;
+        for (float e : err) { sum += e; }
+        printf("%-6s failed %4zu  mean=%.4f p50=%.4f p90=%.4f max=%.4f %s\n", name, failed, sum / (double)err.size(),
+               percentile(0.5), percentile(0.9), err.back(), unit);
+    }
+};
+
+static void usage()
+{
+    fprintf(stderr, "usage: quad_sim [-n trials] [-s snr_db] [-t tolerance_us] [-d direction_deg] [-x failed_pct] [-u] [seed]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    size_t trials = 500;
+    float snr_db = 30.0f;
+    float tolerance = 0.5f;     // us, a tenth of a frame
+    float tol_direction = 1.0f; // deg
+    float max_failed = 5.0f;    // % of the trials
+    bool synced = true;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) { trials = (size_t)atol(argv[++i]); }
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) { snr_db = (float)atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) { tolerance = (float)atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc) { tol_direction = (float)atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-x") && i + 1 < argc) { max_failed = (float)atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-u")) { synced = false; }
+        else if (argv[i][0] == '-') { usage(); }
+        else { seed = (uint32_t)strtoul(argv[i], nullptr, 0); }
+    }
+    if (trials == 0) { usage(); }
+
+    static BasicQuadSampler<SimQuadSource> sampler;
+    static QuadWindow window;
+    static float frames[CHANNELS * FRAMES_PER_SIGNAL];
+    sampler.source.seed = seed;
+
+    Solver solver;
+    DirectionSolver<QUAD_CHANNELS> direction(QUAD_MIC_POSITIONS);
+    direction.slip_us = 1e6f / CARRIER_HZ;
+    PairStats stats[N_PAIRS], within, across, angle, residual, slipped;
+    size_t sync_failed = 0, sync_off = 0, missed = 0, off = 0;
+    for (size_t k = 0; k < trials; k++)
+    {
+        SimQuadSource& source = sampler.source;
+        float az = (-180.0f + 360.0f * SyntheticBurst::uniform(seed)) / RAD_TO_DEG;
+        float el = SIM_MAX_ELEVATION * (2.0f * SyntheticBurst::uniform(seed) - 1.0f) / RAD_TO_DEG;
+        source.direction[0] = -cosf(el) * sinf(az); // azimuth positive towards the left, as DirectionSolver
+        source.direction[1] = cosf(el) * cosf(az);
+        source.direction[2] = sinf(el);
+
+        SyntheticBurst& burst = source.burst;
+        burst = SyntheticBurst();
+        burst.amplitude = 0.02f + 0.08f * SyntheticBurst::uniform(seed);
+        burst.rise = 96.0f;
+        burst.phase = 2.0f * (float)M_PI * SyntheticBurst::uniform(seed);
+        burst.noise_rms = burst.amplitude / sqrtf(2.0f) * powf(10.0f, -snr_db / 20.0f);
+        burst.onset = INFINITY; // silent until the trigger
+
+        if (synced)
+        {
+            if (!sampler.begin()) { sync_failed++; continue; }
+            for (int p = 0; p < QUAD_PORTS; p++)
+            {
+                if (sampler.read_index[p] != source.stream_index(p)) { sync_off++; break; }
+            }
+        }
+        else
+        {
+            source.begin();
+            sampler.read_index[0] = sampler.read_index[1] = source.write_index();
+        }
+
+        for (int r = 0; r < SIM_DRAIN_ROUNDS; r++)
+        {
+            source.wait_frames(SIM_DRAIN_FRAMES);
+            sampler.drain();
+        }
+
+        uint64_t trigger = source.write_index();
+        burst.onset = (float)trigger + SIM_ONSET_MIN + SIM_ONSET_SPAN * SyntheticBurst::uniform(seed);
+        window.trigger_index = trigger;
+        if (!sampler.capture(trigger, window)) { missed++; continue; }
+
+        TdoaPair tdoa[N_PAIRS];
+        size_t n_tdoa = 0;
+        for (size_t i = 0; i < N_PAIRS; i++)
+        {
+            int a = PAIRS[i][0], b = PAIRS[i][1];
+            float thresholds[CHANNELS], t_diff, sig_delay;
+            Measurement m;
+            window.pair(a, b, frames, thresholds);
+            solver.set_thresholds(thresholds);
+            bool cross = a / CHANNELS != b / CHANNELS;
+            if (!solver.solve(frames, window.n_frames, t_diff, sig_delay, m))
+            {
+                stats[i].failed++;
+                (cross ? across : within).failed++;
+                continue;
+            }
+            float truth = (source.delay(b) - source.delay(a)) * SAMPLE_T_US;
+            float err = fabsf(t_diff - truth);
+            stats[i].err.push_back(err);
+            (cross ? across : within).err.push_back(err);
+            tdoa[n_tdoa++] = TdoaPair{ (uint8_t)a, (uint8_t)b, t_diff };
+        }
+
+        // Angle between the solved and the true direction.
+        Direction d;
+        if (!direction.solve(tdoa, n_tdoa, d) || d.rank < 3) { angle.failed++; continue; }
+        float a = d.azimuth / RAD_TO_DEG, e = d.elevation / RAD_TO_DEG;
+        float u[3] = { -cosf(e) * sinf(a), cosf(e) * cosf(a), sinf(e) };
+        float c = u[0] * source.direction[0] + u[1] * source.direction[1] + u[2] * source.direction[2];
+        float err = acosf(fminf(1.0f, fmaxf(-1.0f, c))) * RAD_TO_DEG;
+        angle.err.push_back(err);
+        residual.err.push_back(d.residual_us);
+        slipped.err.push_back((float)d.slipped);
+        if (err > tol_direction) { off++; }
+    }
+
+    printf("trials %zu, snr %.1f dB, %s: sync failed %zu, sync off %zu, capture missed %zu\n", trials, snr_db,
+           synced ? "synced" : "unsynced", sync_failed, sync_off, missed);
+    for (size_t i = 0; i < N_PAIRS; i++)
+    {
+        char name[8];
+        snprintf(name, sizeof(name), "%d-%d", PAIRS[i][0], PAIRS[i][1]);
+        stats[i].print(name);
+    }
+    within.print("within");
+    across.print("across");
+    angle.print("dir", "deg");
+    residual.print("resid");
+    slipped.print("slips", "pairs");
+
+    // Every trial without a direction counts as failed, failed syncs and captures too.
+    float excess = across.percentile(0.5) - within.percentile(0.5);
+    size_t no_direction = trials - angle.err.size();
+    float failed_pct = 100.0f * (float)(no_direction + off) / (float)trials;
+    bool pass = sync_failed == 0 && sync_off == 0 && missed == 0 && excess <= tolerance && failed_pct <= max_failed;
+    printf("%s: across the ports p50 %+.4f us against within (tolerance %.3f us),\n"
+           "      direction: %zu of %zu trials without one, %zu more than %.3f deg off (%.1f%%, at most %.1f%%)\n",
+           pass ? "PASS" : "FAIL", excess, tolerance, no_direction, trials, off, tol_direction, failed_pct, max_failed);
+    return pass ? 0 : 1;
+}
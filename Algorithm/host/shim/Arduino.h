@@ -0,0 +1,38 @@
+#pragma once
+// Minimal Arduino surface for building the DSP sources on a PC (see host/README.md).
+// Serial is silent: the host tools print their own results.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY 0xffffffffu
+
+static inline unsigned long micros()
+{
+    using namespace std::chrono;
+    return (unsigned long)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+static inline unsigned long millis() { return micros() / 1000; }
+
+struct HostSerial {
+    void begin(unsigned long) {}
+    template <class... A> void print(A...) {}
+    template <class... A> void println(A...) {}
+    template <class... A> void printf(const char*, A...) {}
+    void flush() {}
+};
+inline HostSerial Serial;
+
+// Nanoseconds instead of CPU cycles.
+struct HostEsp {
+    uint32_t getCycleCount()
+    {
+        using namespace std::chrono;
+        return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+};
+inline HostEsp ESP;
@@ -0,0 +1,12 @@
+#pragma once
+// No NVS on the host: nothing is stored, load() keeps the defaults.
+#include <stddef.h>
+
+class Preferences {
+public:
+    bool begin(const char*, bool = false) { return false; }
+    void end() {}
+    size_t getBytesLength(const char*) { return 0; }
+    size_t getBytes(const char*, void*, size_t) { return 0; }
+    size_t putBytes(const char*, const void*, size_t) { return 0; }
+};
@@ -0,0 +1,138 @@
+// Converts the text of trace_dump() (see ../Trace.h) into Chrome trace JSON, for
+// chrome://tracing or ui.perfetto.dev. Other lines in the input, such as the rest of a
+// Serial log, are ignored. Every dump in the input becomes one process, each core a thread.
+//
+//   trace_to_chrome [input] > trace.json
+//
+// Reads stdin when no input is given. Build: see README.md.
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct Event {
+    uint32_t ccount;
+    char phase;
+    std::string name;
+};
+
+struct Core {
+    bool anchored = false;
+    uint32_t anchor_ccount = 0;
+    long long anchor_us = 0;
+    std::vector<Event> events; // oldest first
+};
+
+static bool first_record = true;
+
+static void emit(const char* json)
+{
+    printf("%s\n    %s", first_record ? "" : ",", json);
+    first_record = false;
+}
+
+static std::string escaped(const std::string& s)
+{
+    std::string out;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\') { out += '\\'; }
+        if ((unsigned char)c >= 0x20) { out += c; }
+    }
+    return out;
+}
+
+// Timestamps are found by counting cycles back from the anchor, newest event first, so a
+// CCOUNT wrap between two events is only missed when they are more than 2^32 cycles apart.
+static void emit_dump(int pid, unsigned mhz, std::vector<Core>& cores)
+{
+    char buf[512];
+    snprintf(buf, sizeof(buf), "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"dump %d\"}}", pid, pid);
+    emit(buf);
+
+    for (size_t c = 0; c < cores.size(); c++)
+    {
+        Core& core = cores[c];
+        if (!core.anchored || core.events.empty()) { continue; }
+        snprintf(buf, sizeof(buf), "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %zu, \"args\": {\"name\": \"core %zu\"}}", pid, c, c);
+        emit(buf);
+
+        std::vector<double> ts(core.events.size());
+        uint64_t age = 0;
+        uint32_t later = core.anchor_ccount;
+        for (size_t i = core.events.size(); i-- > 0;)
+        {
+            age += (uint32_t)(later - core.events[i].ccount);
+            later = core.events[i].ccount;
+            ts[i] = (double)core.anchor_us - (double)age / (double)mhz;
+        }
+
+        // The ring overwrites the oldest events, so an end may have lost its begin.
+        int depth = 0;
+        for (size_t i = 0; i < core.events.size(); i++)
+        {
+            const Event& e = core.events[i];
+            if (e.phase == 'E' && depth == 0) { continue; }
+            depth += (e.phase == 'B') ? 1 : (e.phase == 'E') ? -1 : 0;
+            snprintf(buf, sizeof(buf), "{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": %d, \"tid\": %zu%s}",
+                     escaped(e.name).c_str(), e.phase, ts[i], pid, c, (e.phase == 'i') ? ", \"s\": \"t\"" : "");
+            emit(buf);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 2) { fprintf(stderr, "usage: trace_to_chrome [input]\n"); return 2; }
+    FILE* in = (argc == 2) ? fopen(argv[1], "r") : stdin;
+    if (!in) { perror(argv[1]); return 1; }
+
+    printf("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    int dumps = 0;
+    size_t events = 0;
+    bool in_dump = false;
+    unsigned mhz = 240;
+    std::vector<Core> cores;
+
+    char line[512];
+    while (fgets(line, sizeof(line), in))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        unsigned u, core, ccount;
+        long long us;
+        char phase;
+        char name[256];
+
+        if (!strcmp(line, "trace,end"))
+        {
+            if (in_dump) { emit_dump(dumps++, mhz, cores); }
+            in_dump = false;
+        }
+        else if (sscanf(line, "trace,%u", &u) == 1)
+        {
+            in_dump = true;
+            mhz = u ? u : 240;
+            cores.clear();
+        }
+        else if (!in_dump) { continue; }
+        else if (sscanf(line, "anchor,%u,%u,%lld", &core, &ccount, &us) == 3 && core < 64)
+        {
+            if (core >= cores.size()) { cores.resize(core + 1); }
+            cores[core].anchored = true;
+            cores[core].anchor_ccount = ccount;
+            cores[core].anchor_us = us;
+        }
+        else if (sscanf(line, "ev,%u,%u,%c,%255[^\n]", &core, &ccount, &phase, name) == 4 && core < cores.size())
+        {
+            cores[core].events.push_back({ ccount, phase, name });
+            events++;
+        }
+    }
+    if (in_dump) { emit_dump(dumps++, mhz, cores); } // cut off log, convert what arrived
+
+    printf("\n]}\n");
+    if (in != stdin) { fclose(in); }
+    fprintf(stderr, "%d dump(s), %zu events\n", dumps, events);
+    return 0;
+}
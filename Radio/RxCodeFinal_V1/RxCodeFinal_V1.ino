@@ -1,5 +1,6 @@
 #include "CC1101.h"
 #include <ESP32Servo.h>
+#include "Trace.h"
 
 // --- Radio Pins ---
 #define PIN_SCK 18
@@ -40,6 +41,7 @@ volatile int speed = 0;
 
 // ISR: Wakes up the task when packet arrives
 void IRAM_ATTR isrGDO0() {
+  TRACE_SCOPE("gdo0_isr");
   vTaskNotifyGiveFromISR(radioRxHandle, NULL);
 }
 
@@ -96,7 +98,13 @@ void setup() {
 
 // --- Do Nothing Code ---
 void loop() {
+  #ifdef TRACING
+  // 't' on the Serial port dumps the trace, see Trace.h.
+  if (Serial.read() == 't') { trace_dump(); }
+  vTaskDelay(pdMS_TO_TICKS(100));
+  #else
   vTaskDelay(portMAX_DELAY);
+  #endif
 }
 
 void radioRx(void* pvParameters) {
@@ -111,7 +119,14 @@ void radioRx(void* pvParameters) {
     uint8_t length;
     int8_t rssi;
 
-    if (radio.checkPacket(buffer, length, rssi)) {
+    bool received;
+    {
+      TRACE_SCOPE("radio_check_packet");
+      received = radio.checkPacket(buffer, length, rssi);
+    }
+
+    if (received) {
+      TRACE_INSTANT("radio_packet");
       // 3. Safety: Ensure the string ends with 0 so atoi works
       buffer[10] = '\0'; 
       
@@ -130,7 +145,10 @@ void radioRx(void* pvParameters) {
 void motorCtrl(void* pvParameters) {
   for (;;) {
     // Write the value received from the radio
-    ledcWrite(PIN_REN, speed); 
+    {
+      TRACE_SCOPE("motor_write");
+      ledcWrite(PIN_REN, speed);
+    }
     vTaskDelay(pdMS_TO_TICKS(50)); // Check for updates every 50ms
   }
 }
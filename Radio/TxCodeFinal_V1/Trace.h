@@ -0,0 +1 @@
+../../Algorithm/Trace.h
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "CC1101.h"
 #include "Ultrasonic_sender.h"
+#include "Trace.h"
 
 // Define Pins
 #define PIN_SCK   18
@@ -31,6 +32,10 @@ unsigned long lastTime = 0;
 #define SAMPLE_FREQ 1
 #define SAMPLE_MS 1.0f / SAMPLE_FREQ * 1000.0f
 
+// Burst period. The receiver's free-running mode times distance against this schedule,
+// so it must match TX_PERIOD_MS in Algorithm.h.
+#define TX_PERIOD_MS 1000
+
 // --- Initialize Code ---
 void setup() { 
   Serial.begin(115200);
@@ -77,18 +82,32 @@ void setup() {
 
 // --- Do Nothing Code ---
 void loop() {
+  #ifdef TRACING
+  // 't' on the Serial port dumps the trace, see Trace.h.
+  if (Serial.read() == 't') { trace_dump(); }
+  vTaskDelay(pdMS_TO_TICKS(100));
+  #else
   vTaskDelay(portMAX_DELAY);
+  #endif
 }
 
 void radioTxTask(void *pvParameters) {
+  // Fixed period from the first wake-up, independent of how long sending takes.
+  TickType_t lastWake = xTaskGetTickCount();
   for (;;) {
     char msg[11];
     sprintf(msg, "%010d", speed);
 
+    {
+      TRACE_SCOPE("radio_send");
+      radio.sendPacket((uint8_t *)msg, 10);
+    }
+    {
+      TRACE_SCOPE("ultrasonic_burst");
+      us.sendPulses(25);
+    }
     Serial.printf("TX: %s\n", msg);
-    radio.sendPacket((uint8_t *)msg, 10);
-    us.sendPulses(25);
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(TX_PERIOD_MS));
   }
 }
 